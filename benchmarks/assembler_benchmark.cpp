@@ -0,0 +1,146 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/resource.h>
+#endif
+
+#include "assembler.h"
+#include "source_file.h"
+
+// Measures the throughput of the assembler on a large generated source
+//
+//     assembler_benchmark [millions of lines] [source file]
+//
+// Writes a synthetic `.vmasm` file (`synthetic.vmasm` by default) with a
+//  small data section and the given number of millions of instructions
+//  (5 by default) in mixed case, then translates it into `<source>.vmexe`.
+//  The peak resident memory shows that the memory use does not grow with
+//  the size of the source.
+
+namespace
+{
+    // False if the file can not be written
+    bool Generate(const std::string &path, unsigned long long line_count)
+    {
+        std::FILE *file = std::fopen(path.c_str(), "wb");
+        if (file == NULL) {
+            return false;
+        }
+
+        static const char *const REGISTERS = "abcABC";
+
+        std::fputs("; synthetic program\n.data 4096\n", file);
+        for (int i = 0; i < 1000; ++i) {
+            std::fprintf(file, ".word %d %d %d %d %d %d %d %d\n",
+                         i, -i, i * 3, i * 5, i * 7, i * 11, i * 13, i * 17);
+        }
+        std::fputs(".bss 1024\n.code\n.entry\n", file);
+
+        // A linear congruential generator keeps the output reproducible
+        unsigned long long state = 42;
+        for (unsigned long long i = 0; i < line_count; ++i) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            unsigned int random = static_cast<unsigned int>(state >> 33);
+            char target = REGISTERS[random % 6];
+            int value = static_cast<int>(random >> 8) % 100000;
+            switch (random % 8)
+            {
+                case 0: case 1: case 2:
+                    std::fprintf(file, "mov %c %d\n", target, value - 50000);
+                    break;
+                case 3:
+                    std::fprintf(file, "  MOV\t%c  %d\r\n", target, value);
+                    break;
+                case 4:
+                    std::fprintf(file, "ld %c %d\n", target, 4096 + value % 8000);
+                    break;
+                case 5:
+                    std::fprintf(file, "st %c %d\n", target, 4096 + value % 8000);
+                    break;
+                case 6:
+                    std::fprintf(file, "jmp %d\n", value % 64 - 32);
+                    break;
+                default:
+                    std::fprintf(file, "int %d\n", value % 4);
+                    break;
+            }
+        }
+
+        return std::fclose(file) == 0;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long long millions_of_lines = 5;
+    if (argc > 1) {
+        millions_of_lines = std::strtoull(argv[1], NULL, 10);
+    }
+
+    std::string source_path = "synthetic.vmasm";
+    if (argc > 2) {
+        source_path = argv[2];
+    }
+    std::string output_path = source_path + ".vmexe";
+
+    if (!Generate(source_path, millions_of_lines * 1000000)) {
+        std::cerr << "Benchmark: failed to write the source file."
+                  << std::endl;
+
+        return -1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    svmasm::SourceFile source;
+    if (!source.Open(source_path)) {
+        std::cerr << "Benchmark: failed to open the source file."
+                  << std::endl;
+
+        return -1;
+    }
+    std::size_t source_size = source.End() - source.Begin();
+
+    std::FILE *output_file = std::fopen(output_path.c_str(), "wb");
+    if (output_file == NULL) {
+        std::cerr << "Benchmark: failed to open the output file."
+                  << std::endl;
+
+        return -1;
+    }
+
+    svmasm::Assembler assembler(output_file, false);
+    bool is_assembled = assembler.Assemble(source);
+    bool is_closed = std::fclose(output_file) == 0;
+
+    auto end = std::chrono::steady_clock::now();
+
+    if (!is_assembled || !is_closed) {
+        return -1;
+    }
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double megabytes = source_size / (1024.0 * 1024.0);
+    std::cout << "lines: " << assembler.LineCount()
+              << ", megabytes: " << megabytes
+              << ", code cells: " << assembler.CodeSize()
+              << ", data cells: " << assembler.DataSize()
+              << ", seconds: " << seconds
+              << ", megabytes per second: " << megabytes / seconds
+              << ", lines per second: " << assembler.LineCount() / seconds
+              << std::endl;
+
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        // Kilobytes on Linux, bytes on macOS
+        std::cout << "peak resident memory: " << usage.ru_maxrss << std::endl;
+    }
+#endif
+
+    return 0;
+}
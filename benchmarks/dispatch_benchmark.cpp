@@ -0,0 +1,153 @@
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "board.h"
+#include "executable.h"
+
+// Measures the raw instruction throughput of the CPU dispatch engine
+//
+//     dispatch_benchmark_<engine> <.vmexe file> [millions of instructions]
+//                                                [timer frequency]
+//
+// The code is placed at the start of RAM and executed without the kernel.
+//  Programs that stop (`int`) are restarted from the entry point, so a looping
+//  image like `write_to_register_in_loop` gives the most meaningful numbers.
+//
+// The `cpu` run drives `CPU::Run` directly, the `board` run goes through
+//  `Board::Start` with the timer firing every `timer frequency` instructions.
+
+namespace
+{
+    // Returns the number of loaded cells of the code or zero on failure,
+    //  the data section is ignored
+    svm::Memory::ram_size_type LoadImage(const std::string &name,
+                                         svm::Memory &memory,
+                                         svm::Memory::ram_size_type &entry_point)
+    {
+        std::shared_ptr<const svm::Executable> executable =
+            svm::Executable::Open(name);
+        if (!executable) {
+            return 0;
+        }
+
+        svm::Memory::ram_size_type size = executable->CodeSize();
+        if (size == 0 || size > memory.ram.size()) {
+            std::cerr << "Benchmark: invalid program size."
+                      << std::endl;
+
+            return 0;
+        }
+
+        std::copy(executable->Code(), executable->Code() + size,
+                  memory.ram.begin());
+        entry_point = executable->EntryPoint();
+
+        return size;
+    }
+
+    void Report(const char *mode, unsigned long long instructions,
+                std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end)
+    {
+        double seconds = std::chrono::duration<double>(end - start).count();
+
+        std::cout << "engine: " << svm::CPU::DISPATCH_ENGINE
+#if defined(SVM_PROFILE_SEQUENCES)
+                  << " (profiling)"
+#elif defined(SVM_NO_FUSION)
+                  << " (unfused)"
+#endif
+                  << ", mode: " << mode
+                  << ", instructions: " << instructions
+                  << ", seconds: " << seconds
+                  << ", instructions per second: "
+                  << static_cast<unsigned long long>(instructions / seconds)
+                  << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    using namespace svm;
+
+    if (argc < 2) {
+        std::cerr << "The syntax of the command is incorrect."
+                  << std::endl
+                  << " dispatch_benchmark <.vmexe file> [millions of instructions]"
+                  << " [timer frequency]"
+                  << std::endl << std::endl;
+
+        return -1;
+    }
+
+    unsigned long long instructions = 100;
+    if (argc > 2) {
+        instructions = std::strtoull(argv[2], NULL, 10);
+    }
+    instructions *= 1000000ULL;
+
+    PIT::frequency_type frequency = 1000;
+    if (argc > 3) {
+        frequency = static_cast<PIT::frequency_type>(
+                        std::strtoul(argv[3], NULL, 10));
+    }
+    if (frequency == 0) {
+        frequency = 1;
+    }
+
+    Board board;
+    Memory::ram_size_type entry_point = 0;
+    Memory::ram_size_type size = LoadImage(argv[1], board.memory, entry_point);
+    if (size == 0) {
+        return -1;
+    }
+    board.cpu.TranslateImage(0, size);
+    board.cpu.registers.ip = entry_point;
+
+    Memory::page_table_type *page_table = board.memory.CreateEmptyPageTable();
+    board.cpu.SwitchAddressSpace(page_table, 0);
+    board.pic.SetISR(PIC::SoftwareInterruptVector(1), [&]() {
+        board.cpu.registers.ip = entry_point;
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long long executed = 0; executed < instructions;) {
+        executed += board.cpu.Run(instructions - executed);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    Report("cpu", instructions, start, end);
+
+    unsigned long long interrupts = instructions / frequency;
+    board.pit.frequency = frequency;
+    board.pic.SetISR(PIC::TIMER_VECTOR, [&]() {
+        if (--interrupts == 0) {
+            board.Stop();
+        }
+    });
+    board.cpu.registers.ip = entry_point;
+
+    start = std::chrono::steady_clock::now();
+    if (interrupts > 0) {
+        board.Start();
+    }
+    end = std::chrono::steady_clock::now();
+
+    Report("board", instructions / frequency * frequency, start, end);
+
+    std::cout << "TLB hits: " << board.cpu.tlb.hits
+              << ", misses: " << board.cpu.tlb.misses
+              << std::endl;
+
+    if (!board.cpu.profile.IsEmpty()) {
+        board.cpu.profile.Report(std::cout);
+    }
+
+    delete page_table;
+
+    return 0;
+}
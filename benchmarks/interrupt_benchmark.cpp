@@ -0,0 +1,127 @@
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include "pic.h"
+
+// Measures the cost of raising an interrupt
+//
+//     interrupt_benchmark [millions of interrupts]
+//
+// `std::function` is the interrupt slot the PIC used before the flat vector
+//  of function pointers and is kept here as the baseline.
+
+namespace
+{
+    struct Counter
+    {
+        unsigned long long count;
+
+        Counter() : count(0) { }
+
+        void Increment()
+        {
+            ++count;
+        }
+    };
+
+    void IncrementCounter(void *context)
+    {
+        ++static_cast<Counter *>(context)->count;
+    }
+
+    void Report(const char *mode, unsigned long long interrupts,
+                std::chrono::steady_clock::time_point start,
+                std::chrono::steady_clock::time_point end,
+                const Counter &counter)
+    {
+        double seconds = std::chrono::duration<double>(end - start).count();
+
+        std::cout << "interrupt: " << mode
+                  << ", interrupts: " << counter.count
+                  << ", nanoseconds per interrupt: "
+                  << seconds * 1e9 / interrupts
+                  << std::endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    using namespace svm;
+
+    unsigned long long interrupts = 100;
+    if (argc > 1) {
+        interrupts = std::strtoull(argv[1], NULL, 10);
+    }
+    interrupts *= 1000000ULL;
+
+    // Not a constant, so that the compiler can not resolve the handler
+    unsigned int vector = argc > 2 ? std::atoi(argv[2]) : PIC::TIMER_VECTOR;
+    if (vector >= PIC::VECTOR_COUNT) {
+        vector = PIC::TIMER_VECTOR;
+    }
+
+    {
+        Counter counter;
+        std::vector<std::function<void()> > isrs(PIC::VECTOR_COUNT);
+        isrs[vector] = [&]() {
+            counter.Increment();
+        };
+
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned long long i = 0; i < interrupts; ++i) {
+            isrs[vector]();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        Report("std::function", interrupts, start, end, counter);
+    }
+
+    {
+        Counter counter;
+        PIC pic;
+        pic.SetISR(vector, [&]() {
+            counter.Increment();
+        });
+
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned long long i = 0; i < interrupts; ++i) {
+            pic.Interrupt(vector);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        Report("lambda", interrupts, start, end, counter);
+    }
+
+    {
+        Counter counter;
+        PIC pic;
+        pic.SetISR<Counter, &Counter::Increment>(vector, &counter);
+
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned long long i = 0; i < interrupts; ++i) {
+            pic.Interrupt(vector);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        Report("member function", interrupts, start, end, counter);
+    }
+
+    {
+        Counter counter;
+        PIC pic;
+        pic.SetISR(vector, &IncrementCounter, &counter);
+
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned long long i = 0; i < interrupts; ++i) {
+            pic.Interrupt(vector);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        Report("function pointer", interrupts, start, end, counter);
+    }
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "kernel.h"
+#include "trace.h"
+
+// Measures how the kernel scales with the number of virtual CPUs
+//
+//     scaling_benchmark <.vmexe file> [number of processes] [maximum CPUs]
+//
+// Runs the same short image as many processes (1000 by default) under the
+//  round-robin scheduler on 1, 2, 4, ... CPUs up to the maximum (the number
+//  of host threads by default). The time includes loading the images, the
+//  processes are balanced between the CPUs by work stealing.
+
+int main(int argc, char *argv[])
+{
+    using namespace svm;
+
+    if (argc < 2) {
+        std::cerr << "The syntax of the command is incorrect."
+                  << std::endl
+                  << " scaling_benchmark <.vmexe file> [number of processes]"
+                  << " [maximum CPUs]"
+                  << std::endl << std::endl;
+
+        return -1;
+    }
+
+    unsigned long process_count = 1000;
+    if (argc > 2) {
+        process_count = std::strtoul(argv[2], NULL, 10);
+    }
+
+    unsigned int max_core_count = std::thread::hardware_concurrency();
+    if (argc > 3) {
+        max_core_count = static_cast<unsigned int>(
+                             std::strtoul(argv[3], NULL, 10));
+    }
+    if (max_core_count == 0) {
+        max_core_count = 1;
+    }
+
+    std::vector<std::string> paths(process_count, argv[1]);
+
+    Trace::SetLevel(Trace::Error);
+
+    double single_core_seconds = 0;
+    for (unsigned int core_count = 1; core_count <= max_core_count;
+            core_count *= 2) {
+        // The kernel reports to the standard output, only the summary of
+        //  the run is interesting here
+        std::ostringstream report;
+        std::streambuf *output = std::cout.rdbuf(report.rdbuf());
+
+        auto start = std::chrono::steady_clock::now();
+        Kernel kernel(Kernel::RoundRobin, paths,
+                      Kernel::quantum_list_type(), core_count);
+        auto end = std::chrono::steady_clock::now();
+
+        std::cout.rdbuf(output);
+
+        unsigned long long steal_count = 0;
+        for (Kernel::processor_list_type::const_iterator it =
+                kernel.processors.begin();
+                it != kernel.processors.end(); ++it) {
+            steal_count += (*it)->steal_count;
+        }
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (core_count == 1) {
+            single_core_seconds = seconds;
+        }
+
+        std::cout << "cpus: " << core_count
+                  << ", processes: " << process_count
+                  << ", seconds: " << seconds
+                  << ", speedup: " << single_core_seconds / seconds
+                  << ", steals: " << steal_count
+                  << std::endl;
+    }
+
+    return 0;
+}
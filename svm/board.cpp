@@ -1,32 +1,83 @@
 #include "board.h"
 
+#include <thread>
+
 namespace svm
 {
-    Board::Board()
-        : memory(),
-          pic(),
-          pit(pic),
-          cpu(memory, pic),
-          _working(false) { }
+    Board::Board(unsigned int core_count, Memory::ram_size_type ram_size,
+                 Memory::ram_size_type page_size,
+                 SwapSpace::size_type swap_size)
+        : memory(ram_size, page_size),
+          swap(swap_size, memory.PageSize()),
+          cores(CreateCores(memory, core_count)),
+          pic(cores.front()->pic),
+          pit(cores.front()->pit),
+          cpu(cores.front()->cpu) { }
 
     Board::~Board() { }
 
     void Board::Start()
     {
-        if (!_working) {
-            _working = true;
+        for (core_list_type::iterator it = cores.begin();
+                it != cores.end(); ++it) {
+            if ((*it)->IsWorking()) {
+                return;
+            }
+        }
 
-            while (_working) {
-                pit.Tick();
-                cpu.Step();
+        // All cores are marked as working before any of them runs, so a
+        //  `Stop` from a core that is already running is not lost
+        std::vector<Core *> online_cores;
+        for (core_list_type::iterator it = cores.begin();
+                it != cores.end(); ++it) {
+            if ((*it)->online) {
+                (*it)->_working = true;
+                online_cores.push_back(it->get());
             }
         }
+        if (online_cores.empty()) {
+            return;
+        }
+
+        std::vector<std::thread> threads;
+        for (std::vector<Core *>::size_type i = 1; i < online_cores.size(); ++i) {
+            threads.push_back(std::thread(&Core::Run, online_cores[i]));
+        }
+
+        online_cores.front()->Run();
+
+        for (std::vector<std::thread>::iterator it = threads.begin();
+                it != threads.end(); ++it) {
+            it->join();
+        }
     }
 
     void Board::Stop()
     {
-        if (_working) {
-            _working = false;
+        for (core_list_type::iterator it = cores.begin();
+                it != cores.end(); ++it) {
+            (*it)->Stop();
         }
     }
+
+    void Board::Reset()
+    {
+        memory.Reset();
+        swap.Reset();
+        for (core_list_type::iterator it = cores.begin();
+                it != cores.end(); ++it) {
+            (*it)->Reset();
+        }
+    }
+
+    Board::core_list_type Board::CreateCores(Memory &memory,
+                                             unsigned int core_count)
+    {
+        core_list_type cores;
+        do {
+            cores.push_back(std::unique_ptr<Core>(new Core(memory)));
+        } while (cores.size() < core_count);
+
+        return cores;
+    }
 }
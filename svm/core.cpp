@@ -0,0 +1,68 @@
+#include "core.h"
+
+#include <algorithm>
+
+namespace svm
+{
+    Core::Core(Memory &memory)
+        : pic(),
+          pit(pic),
+          cpu(memory, pic),
+          online(true),
+          _working(false) { }
+
+    Core::~Core() { }
+
+    void Core::Start()
+    {
+        if (!_working) {
+            _working = true;
+
+            Run();
+        }
+    }
+
+    void Core::Run()
+    {
+        // Equivalent to calling `pit.Tick()` and `cpu.Step()` for every
+        //  instruction: the instructions before the next timer interrupt
+        //  run as one block, then the interrupting tick and the
+        //  instruction after it are executed as before. Latched
+        //  interrupt requests are delivered only on this boundary.
+        while (IsWorking()) {
+            PIT::cycle_count_type block = pit.CyclesUntilInterrupt() - 1;
+            if (block > 0) {
+                CPU::cycle_count_type executed =
+                    cpu.RunBlock(std::min(block, MAX_BLOCK));
+                pit.Advance(executed);
+                cpu.DeliverTrap();
+
+                // The trap at the end of a full block may have stopped
+                //  the core
+                if (executed < block || !IsWorking()) {
+                    continue;
+                }
+            }
+
+            pit.Tick();
+            if (pic.HasPending()) {
+                pic.DeliverPending();
+            }
+            cpu.Step();
+        }
+    }
+
+    void Core::Reset()
+    {
+        pic.Reset();
+        pit.Reset();
+        cpu.Reset();
+
+        online = true;
+    }
+
+    void Core::Stop()
+    {
+        _working = false;
+    }
+}
@@ -1,159 +1,695 @@
-
 #include "cpu.h"
 
 #include <iostream>
 
 namespace svm
 {
+#if defined(SVM_DISPATCH_CHAIN)
+    const char *const CPU::DISPATCH_ENGINE = "chain";
+#elif defined(SVM_DISPATCH_GOTO)
+    const char *const CPU::DISPATCH_ENGINE = "goto";
+#elif defined(SVM_DISPATCH_THREADED)
+    const char *const CPU::DISPATCH_ENGINE = "threaded";
+#else
+    const char *const CPU::DISPATCH_ENGINE = "table";
+#endif
+
+    const CPU::dispatch_table_type CPU::_DISPATCH_TABLE =
+        CPU::CreateDispatchTable();
+
     Registers::Registers()
     : a(0), b(0), c(0), flags(0), ip(0), sp(0) { }
 
     CPU::CPU(Memory &memory, PIC &pic)
     : registers(),
+    tlb(),
+    page_table(NULL),
+    address_space(0),
+    profile(),
     _memory(memory),
-    _pic(pic) { }
+    _pic(pic),
+    _decode_cache(),
+    _threaded_code(),
+    _leave_block(false),
+    _trap_vector(PIC::INVALID_VECTOR),
+    _trap_page(0),
+    _trap_write(false) { }
 
     CPU::~CPU() { }
 
     void CPU::Step()
     {
-        int ip =
-        registers.ip;
+        Run(1);
+    }
+
+    CPU::cycle_count_type CPU::Run(cycle_count_type count)
+    {
+        cycle_count_type executed = RunBlock(count);
+        DeliverTrap();
+
+        return executed;
+    }
+
+    void CPU::Reset()
+    {
+        registers = Registers();
+        tlb.Flush();
+        tlb.hits = tlb.misses = 0;
+        page_table = NULL;
+        address_space = 0;
+
+        _decode_cache.Flush();
+        _threaded_code.Invalidate(0, _memory.ram.size());
+
+        _leave_block = false;
+        _trap_vector = PIC::INVALID_VECTOR;
+        _trap_page = 0;
+        _trap_write = false;
+    }
+
+    void CPU::DeliverTrap()
+    {
+        unsigned int vector = _trap_vector;
+        if (vector == PIC::INVALID_VECTOR) {
+            return;
+        }
+
+        _trap_vector = PIC::INVALID_VECTOR;
+
+        if (vector == PIC::PAGE_FAULT_VECTOR) {
+            // The faulting page is passed to the kernel in the register `a`
+            //  and whether the access was a write in `b`, the instruction is
+            //  restarted after the handler returns
+            int temp_a = registers.a;
+            int temp_b = registers.b;
+            registers.a = static_cast<int>(_trap_page);
+            registers.b = _trap_write ? 1 : 0;
+            _pic.Interrupt(vector);
+            registers.a = temp_a;
+            registers.b = temp_b;
+        } else {
+            _pic.Interrupt(vector);
+        }
+    }
+
+    CPU::cycle_count_type CPU::RunBlock(cycle_count_type count)
+    {
+        cycle_count_type executed = 0;
+        if (count == 0) {
+            return executed;
+        }
+
+        _leave_block = false;
+
+#if defined(SVM_PROFILE_SEQUENCES)
+        do {
+            profile.Record(_memory.ram[registers.ip]);
+
+            const DecodedInstruction &instruction = Fetch(registers.ip);
+            instruction.handler(*this, instruction);
+        } while (++executed < count && !_leave_block);
+#elif defined(SVM_DISPATCH_CHAIN)
+        do {
+            unsigned int ip =
+                registers.ip;
+
+            int instruction =
+                _memory.ram[ip];
+            int data =
+                _memory.ram[ip + 1];
+
+            if (instruction == CPU::MOVA_OPCODE) {
+                registers.a = data;
+                registers.ip += 2;
+            } else if (instruction == CPU::MOVB_OPCODE) {
+                registers.b = data;
+                registers.ip += 2;
+            } else if (instruction == CPU::MOVC_OPCODE) {
+                registers.c = data;
+                registers.ip += 2;
+            } else if (instruction == CPU::JMP_OPCODE) {
+                registers.ip += data;
+            } else if (instruction == CPU::INT_OPCODE) {
+                Interrupt(data);
+            } else if (instruction == CPU::LDA_BASE_OPCODE ||
+                       instruction == CPU::LDB_BASE_OPCODE ||
+                       instruction == CPU::LDC_BASE_OPCODE) {
+                Memory::page_index_offset_pair_type page_offset =
+                    _memory.PageOffsetForVirtual(data);
+
+                int &destination =
+                    instruction == CPU::LDA_BASE_OPCODE ? registers.a :
+                    instruction == CPU::LDB_BASE_OPCODE ? registers.b :
+                                                          registers.c;
+                Load(destination, page_offset.first, page_offset.second);
+            } else if (instruction == CPU::STA_BASE_OPCODE ||
+                       instruction == CPU::STB_BASE_OPCODE ||
+                       instruction == CPU::STC_BASE_OPCODE) {
+                Memory::page_index_offset_pair_type page_offset =
+                    _memory.PageOffsetForVirtual(data);
+
+                int source =
+                    instruction == CPU::STA_BASE_OPCODE ? registers.a :
+                    instruction == CPU::STB_BASE_OPCODE ? registers.b :
+                                                          registers.c;
+                Store(source, page_offset.first, page_offset.second);
+            } else {
+                ExecuteInvalid(*this, _DISPATCH_TABLE[0]);
+            }
+        } while (++executed < count && !_leave_block);
+#elif defined(SVM_DISPATCH_GOTO)
+        static void *const labels[] = {
+            &&invalid, &&mov, &&jmp, &&interrupt, &&load, &&store,
+            &&mov2, &&mov3,
+            &&mov_jmp, &&mov_int,
+            &&mov2_jmp, &&mov2_int
+        };
+
+        const DecodedInstruction *instruction;
+
+        // Direct threading: every handler fetches and dispatches the next
+        //  instruction itself. Handlers that may call into the kernel also
+        //  check whether the block has to end.
+        #define SVM_DISPATCH_NEXT()                                 \
+            if (++executed == count) {                              \
+                return executed;                                    \
+            }                                                       \
+            instruction = &Fetch(registers.ip);                     \
+            goto *labels[instruction->slot]
+
+        #define SVM_DISPATCH_NEXT_OR_LEAVE()                        \
+            if (_leave_block) {                                     \
+                return executed + 1;                                \
+            }                                                       \
+            SVM_DISPATCH_NEXT()
+
+        // A superinstruction that does not fit into the rest of the block
+        //  executes only its first instruction
+        #define SVM_DISPATCH_FUSED()                                \
+            if (count - executed < instruction->length) {           \
+                goto *labels[instruction->base_slot];               \
+            }                                                       \
+            executed += instruction->length - 1
+
+        instruction = &Fetch(registers.ip);
+        goto *labels[instruction->slot];
+
+    mov:
+        registers.*instruction->target = instruction->data;
+        registers.ip += 2;
+        SVM_DISPATCH_NEXT();
+    jmp:
+        registers.ip += instruction->data;
+        SVM_DISPATCH_NEXT();
+    interrupt:
+        Interrupt(instruction->data);
+        SVM_DISPATCH_NEXT_OR_LEAVE();
+    load:
+        Load(registers.*instruction->target,
+             instruction->page, instruction->offset);
+        SVM_DISPATCH_NEXT_OR_LEAVE();
+    store:
+        Store(registers.*instruction->target,
+              instruction->page, instruction->offset);
+        SVM_DISPATCH_NEXT_OR_LEAVE();
+    invalid:
+        ExecuteInvalid(*this, *instruction);
+        SVM_DISPATCH_NEXT();
+    mov2:
+        SVM_DISPATCH_FUSED();
+        registers.*instruction->target = instruction->data;
+        registers.*instruction->fused_target[0] = instruction->fused_data[0];
+        registers.ip += 4;
+        SVM_DISPATCH_NEXT();
+    mov3:
+        SVM_DISPATCH_FUSED();
+        registers.*instruction->target = instruction->data;
+        registers.*instruction->fused_target[0] = instruction->fused_data[0];
+        registers.*instruction->fused_target[1] = instruction->fused_data[1];
+        registers.ip += 6;
+        SVM_DISPATCH_NEXT();
+    mov_jmp:
+        SVM_DISPATCH_FUSED();
+        registers.*instruction->target = instruction->data;
+        registers.ip += 2 + instruction->fused_data[0];
+        SVM_DISPATCH_NEXT();
+    mov_int:
+        SVM_DISPATCH_FUSED();
+        registers.*instruction->target = instruction->data;
+        registers.ip += 2;
+        Interrupt(instruction->fused_data[0]);
+        SVM_DISPATCH_NEXT_OR_LEAVE();
+    mov2_jmp:
+        SVM_DISPATCH_FUSED();
+        registers.*instruction->target = instruction->data;
+        registers.*instruction->fused_target[0] = instruction->fused_data[0];
+        registers.ip += 4 + instruction->fused_data[1];
+        SVM_DISPATCH_NEXT();
+    mov2_int:
+        SVM_DISPATCH_FUSED();
+        registers.*instruction->target = instruction->data;
+        registers.*instruction->fused_target[0] = instruction->fused_data[0];
+        registers.ip += 4;
+        Interrupt(instruction->fused_data[1]);
+        SVM_DISPATCH_NEXT_OR_LEAVE();
+
+        #undef SVM_DISPATCH_FUSED
+        #undef SVM_DISPATCH_NEXT_OR_LEAVE
+        #undef SVM_DISPATCH_NEXT
+#elif defined(SVM_DISPATCH_THREADED)
+        do {
+            const ThreadedInstruction *current =
+                _threaded_code.Find(registers.ip);
+            if (current == NULL) {
+                const DecodedInstruction &instruction = Fetch(registers.ip);
+
+                unsigned int length = instruction.length;
+                if (length <= count - executed) {
+                    instruction.handler(*this, instruction);
+                    executed += length;
+                } else {
+                    instruction.base_handler(*this, instruction);
+                    ++executed;
+                }
+
+                continue;
+            }
+
+            // Follow the direct pointers until the block ends, the code
+            //  leaves the image, or the kernel was called (the handler may
+            //  have dropped the translation, so `current` is not touched
+            //  after that)
+            do {
+                const DecodedInstruction &instruction = current->instruction;
+
+                unsigned int length = instruction.length;
+                if (length > count - executed) {
+                    instruction.base_handler(*this, instruction);
+                    ++executed;
+
+                    break;
+                }
+
+                const ThreadedInstruction *next = current->next;
+                instruction.handler(*this, instruction);
+                executed += length;
+
+                current = next;
+            } while (current != NULL && executed < count && !_leave_block);
+        } while (executed < count && !_leave_block);
+#else
+        do {
+            const DecodedInstruction &instruction = Fetch(registers.ip);
+
+            unsigned int length = instruction.length;
+            if (length <= count - executed) {
+                instruction.handler(*this, instruction);
+                executed += length;
+            } else {
+                instruction.base_handler(*this, instruction);
+                ++executed;
+            }
+        } while (executed < count && !_leave_block);
+#endif
+
+        return executed;
+    }
+
+    void CPU::InvalidateDecodedInstructions(Memory::ram_size_type address,
+                                            Memory::ram_size_type size)
+    {
+        _decode_cache.Invalidate(address, size);
+        _threaded_code.Invalidate(address, size);
+    }
 
-        int instruction =
-        _memory.ram[ip];
+    void CPU::TranslateImage(Memory::ram_size_type address,
+                             Memory::ram_size_type size)
+    {
+#if defined(SVM_DISPATCH_THREADED)
+        ThreadedCode::code_type code(size / 2);
+        for (ThreadedCode::code_type::size_type i = 0; i < code.size(); ++i) {
+            Decode(address + i * 2, code[i].instruction);
+        }
+
+        for (ThreadedCode::code_type::size_type i = 0; i < code.size(); ++i) {
+            const DecodedInstruction &instruction = code[i].instruction;
+
+            Memory::ram_size_type last = address + (i + instruction.length - 1) * 2;
+            Memory::ram_size_type target = last + 2;
+            if (instruction.slot == JMP_SLOT) {
+                target = last + instruction.data;
+            } else if (instruction.slot == MOV_JMP_SLOT ||
+                       instruction.slot == MOV2_JMP_SLOT) {
+                target = last + instruction.fused_data[instruction.length - 2];
+            }
+
+            Memory::ram_size_type offset = target - address;
+            code[i].next =
+                target >= address && offset < code.size() * 2 && offset % 2 == 0 ?
+                    &code[offset / 2] : NULL;
+        }
+
+        _threaded_code.Add(address, code);
+#else
+        (void) address;
+        (void) size;
+#endif
+    }
+
+    CPU::dispatch_table_type CPU::CreateDispatchTable()
+    {
+        DecodedInstruction invalid;
+        invalid.address = DecodeCache::INVALID_ADDRESS;
+        invalid.handler = &CPU::ExecuteInvalid;
+        invalid.slot = INVALID_SLOT;
+        invalid.length = 1;
+        invalid.base_handler = invalid.handler;
+        invalid.base_slot = invalid.slot;
+        invalid.data = 0;
+        invalid.target = NULL;
+        invalid.page = 0;
+        invalid.offset = 0;
+        for (unsigned int i = 0; i < DecodedInstruction::MAX_LENGTH - 1; ++i) {
+            invalid.fused_data[i] = 0;
+            invalid.fused_target[i] = NULL;
+        }
+
+        // Opcode 0 is never valid, `Decode` relies on it for opcodes that
+        //  are out of range
+        dispatch_table_type table;
+        table.fill(invalid);
+
+        DecodedInstruction instruction = invalid;
+
+        instruction.handler = &CPU::ExecuteMov;
+        instruction.slot = MOV_SLOT;
+        instruction.target = &Registers::a;
+        table[MOVA_OPCODE] = instruction;
+        instruction.target = &Registers::b;
+        table[MOVB_OPCODE] = instruction;
+        instruction.target = &Registers::c;
+        table[MOVC_OPCODE] = instruction;
+
+        instruction.handler = &CPU::ExecuteLoad;
+        instruction.slot = LOAD_SLOT;
+        instruction.target = &Registers::a;
+        table[LDA_BASE_OPCODE] = instruction;
+        instruction.target = &Registers::b;
+        table[LDB_BASE_OPCODE] = instruction;
+        instruction.target = &Registers::c;
+        table[LDC_BASE_OPCODE] = instruction;
+
+        instruction.handler = &CPU::ExecuteStore;
+        instruction.slot = STORE_SLOT;
+        instruction.target = &Registers::a;
+        table[STA_BASE_OPCODE] = instruction;
+        instruction.target = &Registers::b;
+        table[STB_BASE_OPCODE] = instruction;
+        instruction.target = &Registers::c;
+        table[STC_BASE_OPCODE] = instruction;
+
+        instruction.target = NULL;
+
+        instruction.handler = &CPU::ExecuteJmp;
+        instruction.slot = JMP_SLOT;
+        table[JMP_OPCODE] = instruction;
+
+        instruction.handler = &CPU::ExecuteInt;
+        instruction.slot = INT_SLOT;
+        table[INT_OPCODE] = instruction;
+
+        for (dispatch_table_type::iterator it = table.begin();
+                it != table.end(); ++it) {
+            it->base_handler = it->handler;
+            it->base_slot = it->slot;
+        }
+
+        return table;
+    }
+
+    const DecodedInstruction &CPU::Fetch(Memory::ram_size_type address)
+    {
+        DecodedInstruction &instruction = _decode_cache.Entry(address);
+        if (instruction.address != address) {
+            Decode(address, instruction);
+        }
+
+        return instruction;
+    }
+
+    void CPU::Decode(Memory::ram_size_type address,
+                     DecodedInstruction &instruction)
+    {
+        int opcode =
+            _memory.ram[address];
         int data =
-        _memory.ram[ip + 1];
+            _memory.ram[address + 1];
 
-        if (instruction ==
-        CPU::MOVA_OPCODE) {
-            registers.a = data;
-            registers.ip += 2;
-        } else if (instruction ==
-        CPU::MOVB_OPCODE) {
-            registers.b = data;
-            registers.ip += 2;
-        } else if (instruction ==
-        CPU::MOVC_OPCODE) {
-            registers.c = data;
+        instruction =
+            static_cast<unsigned int>(opcode) < OPCODE_COUNT ?
+                _DISPATCH_TABLE[opcode] : _DISPATCH_TABLE[0];
+
+        instruction.address = address;
+        instruction.data = data;
+
+        if (instruction.slot == LOAD_SLOT || instruction.slot == STORE_SLOT) {
+            Memory::page_index_offset_pair_type page_offset =
+                _memory.PageOffsetForVirtual(data);
+
+            instruction.page = page_offset.first;
+            instruction.offset = page_offset.second;
+        }
+
+#if !defined(SVM_NO_FUSION) && !defined(SVM_PROFILE_SEQUENCES)
+        if (instruction.slot == MOV_SLOT) {
+            Fuse(address, instruction);
+        }
+#endif
+    }
+
+    void CPU::Fuse(Memory::ram_size_type address,
+                   DecodedInstruction &instruction)
+    {
+        // Collect the `mov` instructions that follow, a `jmp` or `int` ends
+        //  the superinstruction
+        unsigned int slots[DecodedInstruction::MAX_LENGTH - 1];
+
+        unsigned int length = 1;
+        while (length < DecodedInstruction::MAX_LENGTH) {
+            Memory::ram_size_type next = address + length * 2;
+            if (next + 1 >= _memory.ram.size()) {
+                break;
+            }
+
+            int opcode = _memory.ram[next];
+            if (static_cast<unsigned int>(opcode) >= OPCODE_COUNT) {
+                break;
+            }
+
+            const DecodedInstruction &next_instruction =
+                _DISPATCH_TABLE[opcode];
+            if (next_instruction.slot != MOV_SLOT &&
+                    next_instruction.slot != JMP_SLOT &&
+                    next_instruction.slot != INT_SLOT) {
+                break;
+            }
+
+            slots[length - 1] = next_instruction.slot;
+            instruction.fused_data[length - 1] = _memory.ram[next + 1];
+            instruction.fused_target[length - 1] = next_instruction.target;
+            ++length;
+
+            if (next_instruction.slot != MOV_SLOT) {
+                break;
+            }
+        }
+
+        if (length == 1) {
+            return;
+        }
+
+        unsigned int last = slots[length - 2];
+        if (length == 2) {
+            if (last == MOV_SLOT) {
+                instruction.handler = &CPU::ExecuteMov2;
+                instruction.slot = MOV2_SLOT;
+            } else if (last == JMP_SLOT) {
+                instruction.handler = &CPU::ExecuteMovJmp;
+                instruction.slot = MOV_JMP_SLOT;
+            } else {
+                instruction.handler = &CPU::ExecuteMovInt;
+                instruction.slot = MOV_INT_SLOT;
+            }
+        } else if (length == 3) {
+            if (last == MOV_SLOT) {
+                instruction.handler = &CPU::ExecuteMov3;
+                instruction.slot = MOV3_SLOT;
+            } else if (last == JMP_SLOT) {
+                instruction.handler = &CPU::ExecuteMov2Jmp;
+                instruction.slot = MOV2_JMP_SLOT;
+            } else {
+                instruction.handler = &CPU::ExecuteMov2Int;
+                instruction.slot = MOV2_INT_SLOT;
+            }
+        }
+
+        instruction.length = length;
+    }
+
+    void CPU::ExecuteMov(CPU &cpu, const DecodedInstruction &instruction)
+    {
+        cpu.registers.*instruction.target = instruction.data;
+        cpu.registers.ip += 2;
+    }
+
+    void CPU::ExecuteJmp(CPU &cpu, const DecodedInstruction &instruction)
+    {
+        cpu.registers.ip += instruction.data;
+    }
+
+    void CPU::ExecuteInt(CPU &cpu, const DecodedInstruction &instruction)
+    {
+        cpu.Interrupt(instruction.data);
+    }
+
+    void CPU::ExecuteLoad(CPU &cpu, const DecodedInstruction &instruction)
+    {
+        cpu.Load(cpu.registers.*instruction.target,
+                 instruction.page, instruction.offset);
+    }
+
+    void CPU::ExecuteStore(CPU &cpu, const DecodedInstruction &instruction)
+    {
+        cpu.Store(cpu.registers.*instruction.target,
+                  instruction.page, instruction.offset);
+    }
+
+    void CPU::ExecuteInvalid(CPU &cpu, const DecodedInstruction &)
+    {
+        std::cerr << "CPU: invalid opcode data. Skipping..."
+                  << std::endl;
+        cpu.registers.ip += 2;
+    }
+
+    void CPU::ExecuteMov2(CPU &cpu, const DecodedInstruction &instruction)
+    {
+        cpu.registers.*instruction.target = instruction.data;
+        cpu.registers.*instruction.fused_target[0] = instruction.fused_data[0];
+        cpu.registers.ip += 4;
+    }
+
+    void CPU::ExecuteMov3(CPU &cpu, const DecodedInstruction &instruction)
+    {
+        cpu.registers.*instruction.target = instruction.data;
+        cpu.registers.*instruction.fused_target[0] = instruction.fused_data[0];
+        cpu.registers.*instruction.fused_target[1] = instruction.fused_data[1];
+        cpu.registers.ip += 6;
+    }
+
+    void CPU::ExecuteMovJmp(CPU &cpu, const DecodedInstruction &instruction)
+    {
+        cpu.registers.*instruction.target = instruction.data;
+        cpu.registers.ip += 2 + instruction.fused_data[0];
+    }
+
+    void CPU::ExecuteMovInt(CPU &cpu, const DecodedInstruction &instruction)
+    {
+        cpu.registers.*instruction.target = instruction.data;
+        cpu.registers.ip += 2;
+        cpu.Interrupt(instruction.fused_data[0]);
+    }
+
+    void CPU::ExecuteMov2Jmp(CPU &cpu, const DecodedInstruction &instruction)
+    {
+        cpu.registers.*instruction.target = instruction.data;
+        cpu.registers.*instruction.fused_target[0] = instruction.fused_data[0];
+        cpu.registers.ip += 4 + instruction.fused_data[1];
+    }
+
+    void CPU::ExecuteMov2Int(CPU &cpu, const DecodedInstruction &instruction)
+    {
+        cpu.registers.*instruction.target = instruction.data;
+        cpu.registers.*instruction.fused_target[0] = instruction.fused_data[0];
+        cpu.registers.ip += 4;
+        cpu.Interrupt(instruction.fused_data[1]);
+    }
+
+    Memory::page_entry_type CPU::FrameForPage(Memory::page_table_size_type page,
+                                              bool write)
+    {
+        // The TLB caches whole entries. The page table is walked on a miss
+        //  to set the reference bit and on the first write through a clean
+        //  entry to set the dirty bit, so the kernel has to invalidate a
+        //  page after it clears its flags. A shared page is never dirty, a
+        //  write to it always ends up here and faults.
+        Memory::page_entry_type entry;
+        if (!tlb.Lookup(address_space, page, entry) ||
+                (write && (entry & PageTable::DIRTY) == 0)) {
+            PageTable::entry_type *mapping = page_table->Find(page);
+            if (mapping == NULL ||
+                    (write && (*mapping & PageTable::COPY_ON_WRITE) != 0)) {
+                return Memory::INVALID_PAGE;
+            }
+
+            *mapping |= write ? PageTable::REFERENCED | PageTable::DIRTY :
+                                PageTable::REFERENCED;
+            entry = *mapping;
+            tlb.Insert(address_space, page, entry);
+        }
+
+        return PageTable::FrameOf(entry);
+    }
+
+    void CPU::Interrupt(int number)
+    {
+        // The instruction pointer is advanced first so that the kernel
+        //  saves a context that resumes after the `int` instruction
+        registers.ip += 2;
+
+        unsigned int vector = PIC::SoftwareInterruptVector(number);
+        if (vector != PIC::INVALID_VECTOR) {
+            _leave_block = true;
+            _trap_vector = vector;
+        }
+    }
+
+    void CPU::Load(int &destination, Memory::page_table_size_type page,
+                                     Memory::ram_size_type offset)
+    {
+        Memory::page_entry_type frame =
+            FrameForPage(page, false);
+
+        if (frame == Memory::INVALID_PAGE) {
+            PageFault(page, false);
+        } else {
+            destination = _memory.ram[frame + offset];
             registers.ip += 2;
-        } else if (instruction ==
-        CPU::JMP_OPCODE) {
-            registers.ip += data;
-        } else if (instruction ==
-        CPU::INT_OPCODE) {
-          switch (data)
-              {
-                  case 1:
-                      _pic.isr_3();
-                      break;
-                      //case 2:
-                      //  _pic.isr_5(); // `isr_4` is reserved for page fault
-                      //                // exceptions
-                      //  break;
-                      // ...
-              }
-            } else if (instruction == CPU::LDA_BASE_OPCODE)
-            {
-                    Memory::page_index_offset_pair_type pageOffset_i = _memory.PageOffsetForVirtual(data); //We get offset and index
-                    Memory::page_entry_type frame = _memory.page_table->at(pageOffset_i.first);
-                    if(frame == Memory::INVALID_PAGE)
-                    {
-                        int temp = registers.a; //Save register value
-                        registers.a = pageOffset_i.first;
-                        _pic.isr_4(); //Page fault handler call
-                        registers.a = temp; //Restore register value
-                    }
-                    else
-                    {
-                        registers.a = _memory.ram[frame + pageOffset_i.second];
-                        registers.ip += 2; //Increment instruction ptr
-                    }
-            } else if (instruction == CPU::LDB_BASE_OPCODE)
-            {
-                    Memory::page_index_offset_pair_type pageOffset_i = _memory.PageOffsetForVirtual(data);
-                    Memory::page_entry_type frame = _memory.page_table->at(pageOffset_i.first);
-                    if(frame == Memory::INVALID_PAGE)
-                    {
-                        int temp = registers.b;
-                        registers.a = pageOffset_i.first;
-                        _pic.isr_4();
-                        registers.b = temp;
-                    }
-                    else
-                    {
-                        registers.b = _memory.ram[frame + pageOffset_i.second];
-                        registers.ip += 2;
-                    }
-              } else if (instruction == CPU::LDC_BASE_OPCODE)
-              {
-                    Memory::page_index_offset_pair_type pageOffset_i = _memory.PageOffsetForVirtual(data);
-                    Memory::page_entry_type frame = _memory.page_table->at(pageOffset_i.first);
-                    if(frame == Memory::INVALID_PAGE)
-                    {
-                        int temp = registers.c;
-                        registers.c = pageOffset_i.first;
-                        _pic.isr_4();
-                        registers.c = temp;
-                    }
-                    else
-                    {
-                        registers.c = _memory.ram[frame + pageOffset_i.second];
-                        registers.ip += 2;
-                    }
-                }
-              } else if (instruction == CPU::STA_BASE_OPCODE)
-              {
-                    Memory::page_index_offset_pair_type pageOffset_i = _memory.PageOffsetForVirtual(data);
-                    Memory::page_entry_type frame =    _memory.page_table->at(pageOffset_i.first);
-                    if(frame == Memory::INVALID_PAGE)
-                    {
-                        int temp = registers.a;
-                        registers.a = pageOffset_i.first;
-                        _pic.isr_4();
-                        registers.a = temp;
-                    }
-                    else
-                    {
-                        _memory.ram[frame + pageOffset_i.second] = registers.a;
-                        registers.ip += 2;
-                    }
-              } else if (instruction == CPU::STB_BASE_OPCODE)
-              {
-                    Memory::page_index_offset_pair_type pageOffset_i = _memory.PageOffsetForVirtual(data);
-                    Memory::page_entry_type frame = _memory.page_table->at(pageOffset_i.first);
-                    if(frame == Memory::INVALID_PAGE)
-                    {
-                        int temp = registers.b;
-                        registers.b = pageOffset_i.first;
-                        _pic.isr_4();
-                        registers.b = temp;
-                    }
-                    else
-                    {
-                        _memory.ram[frame + pageOffset_i.second] = registers.b;
-                        registers.ip += 2;
-                    }
-              } else if (instruction == CPU::STC_BASE_OPCODE)
-              {
-                    Memory::page_index_offset_pair_type pageOffset_i = _memory.PageOffsetForVirtual(data);
-                    Memory::page_entry_type frame = _memory.page_table->at(pageOffset_i.first);
-                    if(frame == Memory::INVALID_PAGE)
-                    {
-                        int temp = registers.c;
-                        registers.c = pageOffset_i.first;
-                        _pic.isr_4();
-                        registers.c = temp;
-                    }
-                    else
-                    {
-                        _memory.ram[frame + pageOffset_i.second] = registers.c;
-                        registers.ip += 2;
-                    }
-              } else {
-            std::cerr << "CPU: invalid opcode data. Skipping..."
-            << std::endl;
+        }
+    }
+
+    void CPU::Store(int source, Memory::page_table_size_type page,
+                                Memory::ram_size_type offset)
+    {
+        Memory::page_entry_type frame =
+            FrameForPage(page, true);
+
+        if (frame == Memory::INVALID_PAGE) {
+            PageFault(page, true);
+        } else {
+            _memory.ram[frame + offset] = source;
+            _decode_cache.Invalidate(frame + offset);
+            if (_threaded_code.Invalidate(frame + offset)) {
+                _leave_block = true; // The running code may be gone
+            }
             registers.ip += 2;
         }
     }
+
+    void CPU::PageFault(Memory::page_table_size_type page, bool write)
+    {
+        _leave_block = true;
+        _trap_vector = PIC::PAGE_FAULT_VECTOR;
+        _trap_page = page;
+        _trap_write = write;
+    }
 }
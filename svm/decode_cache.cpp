@@ -0,0 +1,36 @@
+#include "decode_cache.h"
+
+namespace svm
+{
+    DecodeCache::DecodeCache(Memory::ram_size_type size)
+        : _entries(size),
+          _mask(size - 1)
+    {
+        Flush();
+    }
+
+    DecodeCache::~DecodeCache() { }
+
+    void DecodeCache::Invalidate(Memory::ram_size_type address,
+                                 Memory::ram_size_type size)
+    {
+        if (size >= _entries.size()) {
+            Flush();
+        } else {
+            for (Memory::ram_size_type i = 0; i < size; ++i) {
+                InvalidateEntry(address + i);
+            }
+            for (Memory::ram_size_type i = 1; i < MAX_SPAN; ++i) {
+                InvalidateEntry(address - i);
+            }
+        }
+    }
+
+    void DecodeCache::Flush()
+    {
+        for (std::vector<DecodedInstruction>::iterator it = _entries.begin();
+                it != _entries.end(); ++it) {
+            it->address = INVALID_ADDRESS;
+        }
+    }
+}
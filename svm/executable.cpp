@@ -0,0 +1,274 @@
+#include "executable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define SVM_EXECUTABLE_MMAP
+#endif
+
+#include "vmexe.h"
+
+namespace svm
+{
+    namespace
+    {
+        // Identity of the contents of a file, a file that was replaced or
+        //  written since it was mapped has another one
+        struct FileVersion
+        {
+            unsigned long long device;
+            unsigned long long inode;
+            unsigned long long size;
+            long long modification_time;
+
+            bool operator==(const FileVersion &other) const
+            {
+                return device == other.device && inode == other.inode &&
+                       size == other.size &&
+                       modification_time == other.modification_time;
+            }
+        };
+
+        // False if the version is unknown, the file is read again then
+        bool GetFileVersion(const std::string &path, FileVersion &version)
+        {
+#if defined(SVM_EXECUTABLE_MMAP)
+            struct stat status;
+            if (stat(path.c_str(), &status) != 0) {
+                return false;
+            }
+
+            version.device = status.st_dev;
+            version.inode = status.st_ino;
+            version.size = status.st_size;
+            version.modification_time = status.st_mtime;
+
+            return true;
+#else
+            (void) path;
+            (void) version;
+
+            return false;
+#endif
+        }
+
+        struct CacheEntry
+        {
+            FileVersion version;
+            std::weak_ptr<const Executable> executable;
+        };
+
+        std::mutex cache_mutex;
+        std::map<std::string, CacheEntry> cache; // By path
+    }
+
+    std::shared_ptr<const Executable> Executable::Open(const std::string &path)
+    {
+        FileVersion version = FileVersion();
+        bool has_version = GetFileVersion(path, version);
+
+        std::lock_guard<std::mutex> lock(cache_mutex);
+
+        std::map<std::string, CacheEntry>::iterator it = cache.find(path);
+        if (it != cache.end()) {
+            std::shared_ptr<const Executable> executable = it->second.executable.lock();
+            if (executable && has_version && it->second.version == version) {
+                return executable;
+            }
+            cache.erase(it);
+        }
+
+        std::shared_ptr<const Executable> executable = Map(path);
+        if (executable && has_version) {
+            CacheEntry entry;
+            entry.version = version;
+            entry.executable = executable;
+            cache.insert(std::make_pair(path, entry));
+        }
+
+        return executable;
+    }
+
+    Executable::Executable()
+        : _cells(NULL),
+          _size(0),
+          _hash(0),
+          _version(0),
+          _code(NULL),
+          _code_size(0),
+          _entry_point(0),
+          _data(NULL),
+          _data_size(0),
+          _data_address(0),
+          _bss_size(0),
+          _mapping(NULL),
+          _mapping_size(0),
+          _buffer() { }
+
+    Executable::~Executable()
+    {
+#if defined(SVM_EXECUTABLE_MMAP)
+        if (_mapping != NULL) {
+            munmap(_mapping, _mapping_size);
+        }
+#endif
+    }
+
+    std::shared_ptr<const Executable> Executable::Map(const std::string &path)
+    {
+        std::shared_ptr<Executable> executable(new Executable());
+
+#if defined(SVM_EXECUTABLE_MMAP)
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0) {
+            std::cerr << "Executable: failed to open the program file." << std::endl;
+
+            return std::shared_ptr<const Executable>();
+        }
+
+        struct stat status;
+        if (fstat(file, &status) == 0 &&
+                static_cast<std::size_t>(status.st_size) >= sizeof(int)) {
+            void *mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+            if (mapping != MAP_FAILED) {
+                executable->_mapping = mapping;
+                executable->_mapping_size = status.st_size;
+                executable->_cells = static_cast<const int *>(mapping);
+                executable->_size = status.st_size / sizeof(int);
+            }
+        }
+        close(file);
+#endif
+
+        // Empty files, hosts without `mmap` and files that can not be
+        //  mapped (e.g., pipes) are read
+        if (executable->_mapping == NULL) {
+            std::ifstream input_stream(path, std::ios::in | std::ios::binary);
+            if (!input_stream) {
+                std::cerr << "Executable: failed to open the program file." << std::endl;
+
+                return std::shared_ptr<const Executable>();
+            }
+
+            input_stream.seekg(0, std::ios::end);
+            std::streamoff file_size = input_stream.tellg();
+            input_stream.seekg(0, std::ios::beg);
+            if (file_size < 0) {
+                file_size = 0;
+            }
+
+            executable->_size = static_cast<size_type>(file_size) / sizeof(int);
+            executable->_buffer.reset(new int[executable->_size + 1]);
+            input_stream.read(reinterpret_cast<char *>(executable->_buffer.get()),
+                              executable->_size * sizeof(int));
+            if (input_stream.bad()) {
+                std::cerr << "Executable: failed to read the program file." << std::endl;
+
+                return std::shared_ptr<const Executable>();
+            }
+            executable->_cells = executable->_buffer.get();
+        }
+
+        // FNV-1a over the cells
+        std::size_t hash = static_cast<std::size_t>(14695981039346656037ULL);
+        for (size_type i = 0; i < executable->_size; ++i) {
+            hash ^= static_cast<unsigned int>(executable->_cells[i]);
+            hash *= static_cast<std::size_t>(1099511628211ULL);
+        }
+        executable->_hash = hash;
+
+        if (!executable->Parse()) {
+            return std::shared_ptr<const Executable>();
+        }
+
+        return executable;
+    }
+
+    bool Executable::Parse()
+    {
+        _code = _cells;
+        _code_size = _size;
+
+        if (_size == 0 || _cells[0] != ExecutableHeader::MAGIC) {
+            // A raw image, unless it is a container from a host with the
+            //  other byte order
+            if (_size > 0) {
+                unsigned int magic = static_cast<unsigned int>(ExecutableHeader::MAGIC);
+                unsigned int swapped = (magic >> 24) | ((magic >> 8) & 0xFF00) |
+                                       ((magic << 8) & 0xFF0000) | (magic << 24);
+                if (static_cast<unsigned int>(_cells[0]) == swapped) {
+                    std::cerr << "Executable: the program file has another byte order." << std::endl;
+
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        const size_type FIXED_SIZE = sizeof(ExecutableHeader) / sizeof(int);
+
+        ExecutableHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(&header, _cells, std::min(_size, FIXED_SIZE) * sizeof(int));
+
+        // Every section has to lie within the file
+        auto section_is_valid = [this](int offset, int size) {
+            return offset >= 0 && size >= 0 &&
+                   static_cast<size_type>(offset) <= _size &&
+                   static_cast<size_type>(size) <= _size - offset;
+        };
+
+        if (header.version < 1 || header.version > ExecutableHeader::VERSION) {
+            std::cerr << "Executable: unsupported program file version " << header.version << "." << std::endl;
+
+            return false;
+        }
+        if (_size < FIXED_SIZE ||
+                header.header_size < static_cast<int>(FIXED_SIZE) ||
+                header.alignment <= 0 || (header.alignment & (header.alignment - 1)) != 0 ||
+                !section_is_valid(0, header.header_size) ||
+                !section_is_valid(header.code_offset, header.code_size) ||
+                !section_is_valid(header.data_offset, header.data_size) ||
+                header.data_address < 0 || header.bss_size < 0 ||
+                header.entry_point < 0 || header.entry_point >= header.code_size ||
+                ((header.flags & ExecutableHeader::HAS_DECODED) != 0 &&
+                 !section_is_valid(header.decoded_offset, header.decoded_size))) {
+            std::cerr << "Executable: invalid program file header." << std::endl;
+
+            return false;
+        }
+
+        _version = header.version;
+        _code = _cells + header.code_offset;
+        _code_size = header.code_size;
+        _entry_point = header.entry_point;
+        _data = _cells + header.data_offset;
+        _data_size = header.data_size;
+        _data_address = header.data_address;
+        _bss_size = header.bss_size;
+
+        return true;
+    }
+
+    bool Executable::HasSameImage(const Executable &other) const
+    {
+        return this == &other ||
+               (_code_size == other._code_size &&
+                _entry_point == other._entry_point &&
+                _data_size == other._data_size &&
+                _data_address == other._data_address &&
+                std::equal(_code, _code + _code_size, other._code) &&
+                std::equal(_data, _data + _data_size, other._data));
+    }
+}
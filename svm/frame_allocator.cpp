@@ -0,0 +1,178 @@
+#include "frame_allocator.h"
+
+namespace svm
+{
+    FrameAllocator::FrameAllocator(size_type frame_count, size_type frame_size)
+        : _frame_count(frame_count),
+          _frame_size(frame_size),
+          _word_count((frame_count + _WORD_BITS - 1) / _WORD_BITS),
+          _words(new std::atomic<word_type>[_word_count]),
+          _free_count(0)
+    {
+        Reset();
+    }
+
+    FrameAllocator::~FrameAllocator() { }
+
+    void FrameAllocator::Reset()
+    {
+        for (size_type word = 0; word < _word_count; ++word) {
+            size_type first = word * _WORD_BITS;
+            size_type bits = _frame_count - first < _WORD_BITS ?
+                                 _frame_count - first : _WORD_BITS;
+
+            word_type value = bits == _WORD_BITS ?
+                                  ~static_cast<word_type>(0) :
+                                  (static_cast<word_type>(1) << bits) - 1;
+            if (word == 0) {
+                value &= ~static_cast<word_type>(1);
+            }
+
+            _words[word].store(value, std::memory_order_relaxed);
+        }
+
+        _free_count.store(_frame_count > 0 ? _frame_count - 1 : 0,
+                          std::memory_order_release);
+    }
+
+    FrameAllocator::frame_type FrameAllocator::Acquire()
+    {
+        for (size_type word = 0; word < _word_count; ++word) {
+            word_type value = _words[word].load(std::memory_order_relaxed);
+            while (value != 0) {
+                word_type bit = value & (~value + 1);
+                if (_words[word].compare_exchange_weak(value, value & ~bit,
+                                                       std::memory_order_acquire,
+                                                       std::memory_order_relaxed)) {
+                    _free_count.fetch_sub(1, std::memory_order_relaxed);
+
+                    return (word * _WORD_BITS + LowestSetBit(bit)) * _frame_size;
+                }
+            }
+        }
+
+        return INVALID_FRAME;
+    }
+
+    void FrameAllocator::Release(frame_type frame)
+    {
+        size_type index = frame / _frame_size;
+
+        _words[index / _WORD_BITS].fetch_or(
+            static_cast<word_type>(1) << (index % _WORD_BITS),
+            std::memory_order_release);
+        _free_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    FrameAllocator::frame_type FrameAllocator::AcquireContiguous(size_type count)
+    {
+        if (count == 0) {
+            return INVALID_FRAME;
+        }
+        if (count == 1) {
+            return Acquire();
+        }
+
+        // Look for a free run in the bitmap, then claim it frame by frame.
+        //  If another core takes a frame of the run first, the claimed ones
+        //  are put back and the search goes on after the taken frame.
+        size_type first = 1;
+        while (first + count <= _frame_count) {
+            size_type length = 0;
+            while (length < count) {
+                size_type index = first + length;
+                word_type value = _words[index / _WORD_BITS].load(std::memory_order_relaxed);
+                if ((value & (static_cast<word_type>(1) << (index % _WORD_BITS))) == 0) {
+                    break;
+                }
+                ++length;
+            }
+            if (length < count) {
+                first += length + 1;
+                continue;
+            }
+
+            size_type claimed = 0;
+            while (claimed < count && Claim(first + claimed)) {
+                ++claimed;
+            }
+            if (claimed == count) {
+                return first * _frame_size;
+            }
+
+            for (size_type i = 0; i < claimed; ++i) {
+                Release((first + i) * _frame_size);
+            }
+            first += claimed + 1;
+        }
+
+        return INVALID_FRAME;
+    }
+
+    bool FrameAllocator::Claim(size_type index)
+    {
+        word_type bit = static_cast<word_type>(1) << (index % _WORD_BITS);
+        word_type value = _words[index / _WORD_BITS].fetch_and(~bit, std::memory_order_acquire);
+        if ((value & bit) == 0) {
+            return false;
+        }
+
+        _free_count.fetch_sub(1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    FrameCache::FrameCache(FrameAllocator &allocator)
+        : _allocator(allocator),
+          _size(0) { }
+
+    FrameCache::~FrameCache()
+    {
+        Drain();
+    }
+
+    FrameAllocator::frame_type FrameCache::Acquire()
+    {
+        if (_size == 0) {
+            // Half of the free frames at most, so a core that runs short
+            //  leaves some to the caches of the others
+            FrameAllocator::size_type batch = _allocator.FreeCount() / 2;
+            if (batch > BATCH) {
+                batch = BATCH;
+            } else if (batch == 0) {
+                batch = 1;
+            }
+
+            while (_size < batch) {
+                FrameAllocator::frame_type frame = _allocator.Acquire();
+                if (frame == FrameAllocator::INVALID_FRAME) {
+                    break;
+                }
+                _frames[_size++] = frame;
+            }
+            if (_size == 0) {
+                return FrameAllocator::INVALID_FRAME;
+            }
+        }
+
+        return _frames[--_size];
+    }
+
+    void FrameCache::Release(FrameAllocator::frame_type frame)
+    {
+        if (_size == CAPACITY) {
+            while (_size > CAPACITY - BATCH) {
+                _allocator.Release(_frames[--_size]);
+            }
+        }
+
+        _frames[_size++] = frame;
+    }
+
+    void FrameCache::Drain()
+    {
+        while (_size > 0) {
+            _allocator.Release(_frames[--_size]);
+        }
+    }
+}
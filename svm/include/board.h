@@ -1,33 +1,59 @@
 #ifndef BOARD_H
 #define BOARD_H
 
+#include <memory>
+#include <vector>
+
 #include "memory.h"
+#include "swap_space.h"
 #include "pic.h"
 #include "pit.h"
 #include "cpu.h"
+#include "core.h"
 
 namespace svm
 {
     // Virtual Machine
     //
-    // Combines all components (CPU, memory, timer, interrupt controller)
+    // Combines all components (CPU cores, memory, swap space, timers,
+    //  interrupt controllers)
     // Orchestrates their execution
+    //
+    // A board with more than one core runs every core but the first one on
+    //  its own host thread. The cores share the memory.
     class Board
     {
         public:
+            typedef std::vector<std::unique_ptr<Core> > core_list_type;
+
             Memory memory;
-            PIC pic;
-            PIT pit;
-            CPU cpu;
+            SwapSpace swap; // Backing store of the memory
+            core_list_type cores;
 
-            Board();
+            // Components of the first core
+            PIC &pic;
+            PIT &pit;
+            CPU &cpu;
+
+            Board(unsigned int core_count = 1,
+                  Memory::ram_size_type ram_size = Memory::DEFAULT_RAM_SIZE,
+                  Memory::ram_size_type page_size = Memory::DEFAULT_PAGE_SIZE,
+                  SwapSpace::size_type swap_size = SwapSpace::DEFAULT_SIZE);
             virtual ~Board();
 
-            void Start(); // Starts the cpu, timer, etc.
-            void Stop();  // Stops...
+            void Start(); // Starts all cores, returns when all are stopped
+            void Stop();  // Stops all cores
+
+            // Clears the memory, the swap space and the cores of a stopped
+            //  board, so it can be reused for other programs
+            void Reset();
 
         private:
-            bool _working;
+            Board(const Board &);
+            Board &operator=(const Board &);
+
+            static core_list_type CreateCores(Memory &memory,
+                                              unsigned int core_count);
     };
 }
 
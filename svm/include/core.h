@@ -0,0 +1,57 @@
+#ifndef CORE_H
+#define CORE_H
+
+#include <atomic>
+
+#include "memory.h"
+#include "pic.h"
+#include "pit.h"
+#include "cpu.h"
+
+namespace svm
+{
+    // Virtual CPU Core
+    //
+    // A CPU with its own interrupt controller and timer. Cores of a board
+    //  share the memory, every core of a multi-core board runs on its own
+    //  host thread.
+    class Core
+    {
+        public:
+            // Longest run of instructions between two checks whether the
+            //  core was stopped from another thread
+            static const PIT::cycle_count_type MAX_BLOCK = 0x10000;
+
+            PIC pic;
+            PIT pit;
+            CPU cpu;
+
+            bool online; // Cores taken offline are not started by the board
+
+            Core(Memory &memory);
+            virtual ~Core();
+
+            void Start(); // Runs the core until it is stopped
+            void Stop();  // Can be called from any thread
+
+            // Puts the stopped core back into its initial state
+            void Reset();
+
+            bool IsWorking() const
+            {
+                return _working.load(std::memory_order_relaxed);
+            }
+
+        private:
+            friend class Board;
+
+            std::atomic<bool> _working;
+
+            Core(const Core &);
+            Core &operator=(const Core &);
+
+            void Run(); // The main loop, until `_working` is cleared
+    };
+}
+
+#endif
@@ -1,7 +1,49 @@
 #ifndef CPU_H
 #define CPU_H
+
+#include <array>
+
 #include "memory.h"
 #include "pic.h"
+#include "decode_cache.h"
+#include "threaded_code.h"
+#include "tlb.h"
+#include "sequence_profile.h"
+
+// Dispatch engine used by `CPU::Step`
+//
+// Selected at build time with `-DSVM_DISPATCH=CHAIN|TABLE|GOTO|THREADED`.
+//
+// CHAIN: the original if/else-if chain over the raw opcodes
+// TABLE: pre-decoded instructions from the decode cache, the handler is
+//        called through a function pointer
+// GOTO:  pre-decoded instructions from the decode cache, computed `goto`
+//        (GCC/Clang), falls back to TABLE elsewhere
+// THREADED: program images are translated into threaded code when they are
+//        loaded (`CPU::TranslateImage`), with `jmp` targets resolved to
+//        direct pointers; code outside of translated images runs as in TABLE
+#if !defined(SVM_DISPATCH_CHAIN) && \
+    !defined(SVM_DISPATCH_TABLE) && \
+    !defined(SVM_DISPATCH_GOTO) && \
+    !defined(SVM_DISPATCH_THREADED)
+    #define SVM_DISPATCH_TABLE
+#endif
+
+#if defined(SVM_DISPATCH_GOTO) && !defined(__GNUC__)
+    #undef SVM_DISPATCH_GOTO
+    #define SVM_DISPATCH_TABLE
+#endif
+
+// Superinstructions
+//
+// TABLE and GOTO fuse common sequences (`mov` followed by `mov`, `jmp` or
+//  `int`, up to three instructions) into one decoded record unless built
+//  with `SVM_NO_FUSION`.
+//
+// Builds with `SVM_PROFILE_SEQUENCES` execute instructions one by one
+//  through the handler table and count the executed opcode pairs and
+//  triples in `CPU::profile` instead.
+
 namespace svm
 {
     // Registers
@@ -30,13 +72,30 @@ namespace svm
                              MOVC_OPCODE = 0x12,
                              JMP_OPCODE  = 0x20,
                              INT_OPCODE  = 0x30,
-                             LDA_BASE_OPCODE=0x20,
-                             LDB_BASE_OPCODE=0x21,
-                             LDC_BASE_OPCODE=0x22,
-                             STA_BASE_OPCODE=0x30,
-                             STB_BASE_OPCODE=0x31,
-                             STC_BASE_OPCODE=0x32;
+                             LDA_BASE_OPCODE=0x40,
+                             LDB_BASE_OPCODE=0x41,
+                             LDC_BASE_OPCODE=0x42,
+                             STA_BASE_OPCODE=0x50,
+                             STB_BASE_OPCODE=0x51,
+                             STC_BASE_OPCODE=0x52;
+
+            static const unsigned int OPCODE_COUNT = 0x100;
+
+            typedef unsigned long long cycle_count_type;
+
+            static const char *const DISPATCH_ENGINE; // Name of the engine
+                                                      //  `Step` was built with
+
             Registers registers; // Current state of the CPU
+            TLB tlb;             // Cached translations of `page_table`
+
+            // Page table of the running process, every core of a board
+            //  translates addresses on its own
+            Memory::page_table_type *page_table;
+            Memory::address_space_type address_space; // Tag of the current
+                                                      //  page table in the TLB
+
+            SequenceProfile profile; // Filled only with `SVM_PROFILE_SEQUENCES`
 
             CPU(Memory &memory, PIC &pic);
             virtual ~CPU();
@@ -44,9 +103,118 @@ namespace svm
             void Step(); // Executes one instruction, advances the instruction
                          //  pointer
 
+            // Executes up to `count` instructions in one tight loop. Returns
+            //  early after an instruction that called into the kernel (an
+            //  `int` or a page fault), so the caller can check whether the
+            //  board was stopped. Returns the number of executed instructions.
+            cycle_count_type Run(cycle_count_type count);
+
+            // Same as `Run`, but the interrupt of the last instruction is
+            //  left pending until `DeliverTrap` is called. The caller can
+            //  account for the executed instructions first, so the kernel
+            //  sees the exact time of the trap.
+            cycle_count_type RunBlock(cycle_count_type count);
+
+            // Calls the ISR of the pending software interrupt or page fault
+            void DeliverTrap();
+
+            // Clears the registers, the TLB and every decoded or translated
+            //  instruction, e.g., before another program set is loaded
+            void Reset();
+
+            // Installs the page table of another process. Every page table
+            //  must be installed with its own address space id (e.g., a
+            //  process id).
+            void SwitchAddressSpace(Memory::page_table_type *page_table,
+                                    Memory::address_space_type address_space)
+            {
+                this->page_table = page_table;
+                this->address_space = address_space;
+            }
+
+            // Must be called after instructions were written into RAM
+            //  by anything other than the CPU itself (e.g., the loader)
+            void InvalidateDecodedInstructions(Memory::ram_size_type address,
+                                               Memory::ram_size_type size);
+
+            // Translates a program image that was just loaded into RAM into
+            //  threaded code (only with the THREADED engine)
+            void TranslateImage(Memory::ram_size_type address,
+                                Memory::ram_size_type size);
+
         private:
+            enum OpcodeSlot
+            {
+                INVALID_SLOT,
+                MOV_SLOT, JMP_SLOT, INT_SLOT, LOAD_SLOT, STORE_SLOT,
+                MOV2_SLOT, MOV3_SLOT,
+                MOV_JMP_SLOT, MOV_INT_SLOT,
+                MOV2_JMP_SLOT, MOV2_INT_SLOT
+            };
+
+            typedef std::array<DecodedInstruction, OPCODE_COUNT>
+                        dispatch_table_type;
+
+            static const dispatch_table_type _DISPATCH_TABLE;
+
             Memory &_memory;
             PIC &_pic;
+
+            DecodeCache _decode_cache;
+            ThreadedCode _threaded_code;
+
+            bool _leave_block; // Set when the kernel has to be called
+                               //  before the block continues
+
+            unsigned int _trap_vector; // Pending software interrupt or
+                                       //  exception
+            Memory::page_table_size_type _trap_page;
+            bool _trap_write; // The faulting access was a store
+
+            static dispatch_table_type CreateDispatchTable();
+
+            const DecodedInstruction &Fetch(Memory::ram_size_type address);
+            void Decode(Memory::ram_size_type address,
+                        DecodedInstruction &instruction);
+            void Fuse(Memory::ram_size_type address,
+                      DecodedInstruction &instruction);
+
+            static void ExecuteMov(CPU &cpu,
+                                   const DecodedInstruction &instruction);
+            static void ExecuteJmp(CPU &cpu,
+                                   const DecodedInstruction &instruction);
+            static void ExecuteInt(CPU &cpu,
+                                   const DecodedInstruction &instruction);
+            static void ExecuteLoad(CPU &cpu,
+                                    const DecodedInstruction &instruction);
+            static void ExecuteStore(CPU &cpu,
+                                     const DecodedInstruction &instruction);
+            static void ExecuteInvalid(CPU &cpu,
+                                       const DecodedInstruction &instruction);
+
+            static void ExecuteMov2(CPU &cpu,
+                                    const DecodedInstruction &instruction);
+            static void ExecuteMov3(CPU &cpu,
+                                    const DecodedInstruction &instruction);
+            static void ExecuteMovJmp(CPU &cpu,
+                                      const DecodedInstruction &instruction);
+            static void ExecuteMovInt(CPU &cpu,
+                                      const DecodedInstruction &instruction);
+            static void ExecuteMov2Jmp(CPU &cpu,
+                                       const DecodedInstruction &instruction);
+            static void ExecuteMov2Int(CPU &cpu,
+                                       const DecodedInstruction &instruction);
+
+            Memory::page_entry_type FrameForPage(
+                                        Memory::page_table_size_type page,
+                                        bool write);
+
+            void Interrupt(int number);
+            void Load(int &destination, Memory::page_table_size_type page,
+                                        Memory::ram_size_type offset);
+            void Store(int source, Memory::page_table_size_type page,
+                                   Memory::ram_size_type offset);
+            void PageFault(Memory::page_table_size_type page, bool write);
     };
 }
 
@@ -0,0 +1,105 @@
+#ifndef DECODE_CACHE_H
+#define DECODE_CACHE_H
+
+#include <vector>
+#include <limits>
+
+#include "memory.h"
+
+namespace svm
+{
+    struct Registers;
+    class CPU;
+
+    // Pre-decoded instruction
+    //
+    // Everything `CPU::Step` needs to execute an instruction without looking
+    //  at the raw opcode and operand in RAM again
+    //
+    // A record may also hold a superinstruction: a short run of `mov`
+    //  instructions, optionally ending with a `jmp` or `int`, that is
+    //  executed in one dispatch. `length` is the number of instructions it
+    //  covers; `base_handler` and `base_slot` execute only the first one.
+    struct DecodedInstruction
+    {
+        typedef void (*handler_type)(CPU &cpu,
+                                     const DecodedInstruction &instruction);
+
+        static const unsigned int MAX_LENGTH = 3;
+
+        Memory::ram_size_type address; // Physical address (the cache tag)
+
+        handler_type handler;
+        unsigned int slot;             // Dense index of the opcode (the
+                                       //  label used by the `GOTO` engine)
+        unsigned int length;
+
+        handler_type base_handler;
+        unsigned int base_slot;
+
+        int data;                      // Immediate operand
+        int Registers::*target;        // Register operand or NULL
+
+        Memory::page_table_size_type page; // Virtual address of LD*/ST*
+        Memory::ram_size_type offset;      //  split into a page and offset
+
+        int fused_data[MAX_LENGTH - 1];    // Operands of the instructions
+        int Registers::*fused_target[MAX_LENGTH - 1]; //  after the first one
+    };
+
+    // Decode Cache
+    //
+    // Direct-mapped cache of decoded instructions keyed by physical address.
+    //  Anything that writes instructions into RAM (ST* opcodes, the program
+    //  loader) has to invalidate the affected addresses.
+    class DecodeCache
+    {
+        public:
+            // Number of entries, must be a power of two
+            static const Memory::ram_size_type DEFAULT_SIZE = 0x1000;
+
+            static const Memory::ram_size_type INVALID_ADDRESS =
+                std::numeric_limits<Memory::ram_size_type>::max();
+
+            DecodeCache(Memory::ram_size_type size = DEFAULT_SIZE);
+            virtual ~DecodeCache();
+
+            // Returns the entry for the address; it holds a valid
+            //  instruction only if its `address` matches
+            DecodedInstruction &Entry(Memory::ram_size_type address)
+            {
+                return _entries[address & _mask];
+            }
+
+            // Number of cells a record can cover
+            static const Memory::ram_size_type MAX_SPAN =
+                DecodedInstruction::MAX_LENGTH * 2;
+
+            // A write to `address` affects every record that starts up to
+            //  `MAX_SPAN - 1` cells before it
+            void Invalidate(Memory::ram_size_type address)
+            {
+                for (Memory::ram_size_type i = 0; i < MAX_SPAN; ++i) {
+                    InvalidateEntry(address - i);
+                }
+            }
+
+            void Invalidate(Memory::ram_size_type address,
+                            Memory::ram_size_type size);
+            void Flush();
+
+        private:
+            std::vector<DecodedInstruction> _entries;
+            Memory::ram_size_type _mask;
+
+            void InvalidateEntry(Memory::ram_size_type address)
+            {
+                DecodedInstruction &entry = Entry(address);
+                if (entry.address == address) {
+                    entry.address = INVALID_ADDRESS;
+                }
+            }
+    };
+}
+
+#endif
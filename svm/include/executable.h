@@ -0,0 +1,116 @@
+#ifndef EXECUTABLE_H
+#define EXECUTABLE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace svm
+{
+    // Program Image File
+    //
+    // A `.vmexe` file (see `ExecutableHeader`, raw images of the code are
+    //  accepted too) mapped read-only into the host memory (read into a
+    //  buffer where there is no `mmap`). `Open` hands out one mapping per
+    //  file to every kernel and thread that loads it at the same time, so
+    //  a file is read once however many processes run it. The mapping goes
+    //  away with the last reference, a file that changed on the disk is
+    //  mapped again.
+    class Executable
+    {
+        public:
+            typedef std::size_t size_type;
+
+            // NULL if the file can not be opened, read or has an invalid
+            //  header, the reason is written to the standard error
+            static std::shared_ptr<const Executable> Open(const std::string &path);
+
+            virtual ~Executable();
+
+            // Version of the container, 0 for a raw image
+            unsigned int Version() const
+            {
+                return _version;
+            }
+
+            // Sections, sizes are in cells
+            const int *Code() const
+            {
+                return _code;
+            }
+
+            size_type CodeSize() const
+            {
+                return _code_size;
+            }
+
+            size_type EntryPoint() const // Offset in the code
+            {
+                return _entry_point;
+            }
+
+            const int *Data() const
+            {
+                return _data;
+            }
+
+            size_type DataSize() const
+            {
+                return _data_size;
+            }
+
+            size_type DataAddress() const // In the data address space
+            {
+                return _data_address;
+            }
+
+            size_type BssSize() const
+            {
+                return _bss_size;
+            }
+
+            // End of the data and the bss in the data address space
+            size_type DataEnd() const
+            {
+                return _data_address + _data_size + _bss_size;
+            }
+
+            // FNV-1a hash of the file, computed when the file is mapped
+            std::size_t Hash() const
+            {
+                return _hash;
+            }
+
+            // Same code, data and layout
+            bool HasSameImage(const Executable &other) const;
+
+        private:
+            const int *_cells;
+            size_type _size;
+            std::size_t _hash;
+
+            unsigned int _version;
+            const int *_code;
+            size_type _code_size;
+            size_type _entry_point;
+            const int *_data;
+            size_type _data_size;
+            size_type _data_address;
+            size_type _bss_size;
+
+            void *_mapping; // NULL if the cells were read into `_buffer`
+            std::size_t _mapping_size;
+            std::unique_ptr<int[]> _buffer;
+
+            Executable();
+            Executable(const Executable &);
+            Executable &operator=(const Executable &);
+
+            static std::shared_ptr<const Executable> Map(const std::string &path);
+
+            // Finds the sections, false if the header is invalid
+            bool Parse();
+    };
+}
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef FRAME_ALLOCATOR_H
+#define FRAME_ALLOCATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace svm
+{
+    // Physical Frame Allocator
+    //
+    // Free frames are kept in a bitmap (a set bit is a free frame) of
+    //  atomic words. A frame is taken by clearing its bit with a CAS, so
+    //  cores of one board and boards that share the allocator never lock.
+    //  The search takes the lowest free frame with a find-first-set on
+    //  every word. Frames are identified by their physical address, the
+    //  frame at the address 0 is never handed out (`INVALID_FRAME`).
+    class FrameAllocator
+    {
+        public:
+            typedef std::size_t frame_type;
+            typedef std::size_t size_type;
+
+            static const frame_type INVALID_FRAME = 0;
+
+            FrameAllocator(size_type frame_count, size_type frame_size);
+            virtual ~FrameAllocator();
+
+            frame_type Acquire(); // INVALID_FRAME if there is none left
+            void Release(frame_type frame);
+
+            // Takes `count` adjacent frames, returns the first one or
+            //  INVALID_FRAME. Each of them is released on its own.
+            frame_type AcquireContiguous(size_type count);
+
+            // Marks every frame but the first one as free
+            void Reset();
+
+            size_type FrameCount() const
+            {
+                return _frame_count;
+            }
+
+            size_type FrameSize() const
+            {
+                return _frame_size;
+            }
+
+            size_type FreeCount() const
+            {
+                return _free_count.load(std::memory_order_relaxed);
+            }
+
+            size_type UsedCount() const
+            {
+                return _frame_count - FreeCount();
+            }
+
+        private:
+            typedef unsigned long long word_type;
+
+            static const size_type _WORD_BITS = sizeof(word_type) * 8;
+
+            size_type _frame_count;
+            size_type _frame_size;
+            size_type _word_count;
+
+            std::unique_ptr<std::atomic<word_type>[]> _words;
+            std::atomic<size_type> _free_count;
+
+            FrameAllocator(const FrameAllocator &);
+            FrameAllocator &operator=(const FrameAllocator &);
+
+            // Clears the bit of a free frame, false if it was taken
+            bool Claim(size_type index);
+
+            static size_type LowestSetBit(word_type word)
+            {
+#if defined(__GNUC__)
+                return static_cast<size_type>(__builtin_ctzll(word));
+#else
+                size_type bit = 0;
+                while ((word & 1) == 0) {
+                    word >>= 1;
+                    ++bit;
+                }
+
+                return bit;
+#endif
+            }
+    };
+
+    // Per-CPU Frame Cache
+    //
+    // A few frames taken from the shared allocator in batches, so page
+    //  faults and exits on one core rarely touch the shared bitmap. Only the
+    //  owning core uses a cache.
+    class FrameCache
+    {
+        public:
+            static const FrameAllocator::size_type CAPACITY = 0x10;
+            static const FrameAllocator::size_type BATCH = CAPACITY / 2;
+
+            FrameCache(FrameAllocator &allocator);
+            virtual ~FrameCache(); // Returns the cached frames
+
+            FrameAllocator::frame_type Acquire();
+            void Release(FrameAllocator::frame_type frame);
+
+            // Returns every cached frame to the allocator
+            void Drain();
+
+            FrameAllocator::size_type Size() const
+            {
+                return _size;
+            }
+
+        private:
+            FrameAllocator &_allocator;
+
+            FrameAllocator::frame_type _frames[CAPACITY];
+            FrameAllocator::size_type _size;
+
+            FrameCache(const FrameCache &);
+            FrameCache &operator=(const FrameCache &);
+    };
+}
+
+#endif
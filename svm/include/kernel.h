@@ -1,12 +1,20 @@
 #ifndef KERNEL_H
 #define KERNEL_H
 
-#include <deque>
-#include <queue>
+#include <atomic>
+#include <ostream>
 #include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include "board.h"
+#include "executable.h"
 #include "process.h"
+#include "run_queue.h"
+#include "work_deque.h"
 
 namespace svm
 {
@@ -18,42 +26,315 @@ namespace svm
             FirstComeFirstServed,
             ShortestJob,
             RoundRobin,
-            Priority
+            Priority,
+            ShortestRemainingTime,
+            MultilevelFeedbackQueue,
+            Undefined
         };
 
-        typedef std::deque<Process> process_list_type;
-        typedef std::priority_queue<Process> process_priorities_type;
+        // Quanta in cycles, one per level of the multilevel feedback queue
+        //  (at most `RunQueue::LEVEL_COUNT`). The other preemptive schedulers
+        //  use the first one.
+        typedef std::vector<CPU::cycle_count_type> quantum_list_type;
+
+        static const CPU::cycle_count_type DEFAULT_QUANTUM = 5;
+
+        // Choice of the page that is evicted when a core runs out of frames.
+        //  Every core replaces pages of its own processes.
+        //
+        // Clock:      second chance, the hand skips and clears referenced
+        //             pages
+        // Aging:      LRU approximation, every page keeps a byte of its
+        //             reference bits from the last replacements, the page
+        //             with the lowest one goes
+        // WorkingSet: WSClock, the first page that was not referenced
+        //             within the window of its process's CPU time goes,
+        //             otherwise the one unused for the longest time
+        enum Replacement
+        {
+            Clock,
+            Aging,
+            WorkingSet
+        };
+
+        static const CPU::cycle_count_type DEFAULT_WORKING_SET_WINDOW = 100;
+
+        // Exit state of a finished process
+        struct ProcessResult
+        {
+            Process::process_id_type id;
+            Registers registers;
+            CPU::cycle_count_type turnaround_time;
+            CPU::cycle_count_type waiting_time;
+            CPU::cycle_count_type cpu_time;
+            Process::counter_type page_fault_count;
+            Process::counter_type swap_in_count;
+            Process::counter_type swap_out_count;
+            Process::counter_type copy_on_write_count;
+        };
+
+        typedef std::vector<ProcessResult> result_list_type;
+
+        // Per-CPU State
+        //
+        // Every core of the board schedules the processes of its own run
+        //  queue. The interrupt handlers of a core only run on the thread of
+        //  that core, so apart from the backlog nothing here is shared
+        //  between the threads.
+        //
+        // Processes wait in the backlog until the core admits them into its
+        //  run queue. A core that runs out of processes steals from the
+        //  backlog of another core.
+        struct Processor
+        {
+            // Page of a process of this core in a frame
+            struct ResidentPage
+            {
+                Process *process;
+                Memory::page_table_size_type page;
+                unsigned char age;              // Aging
+                CPU::cycle_count_type last_use; // Working set, CPU time of
+                                                //  the process
+            };
+
+            typedef std::vector<ResidentPage> resident_list_type;
+
+            unsigned int id;
+            Core &core;
+
+            RunQueue processes;
+            WorkDeque backlog; // Processes that were not started yet
+            FrameCache frames; // Page frames of this core
+
+            resident_list_type resident_pages; // Ring of the replacement
+            resident_list_type::size_type clock_hand;
+            bool is_waiting_for_frame; // Nothing to evict, the frames are
+                                       //  held by other cores
+            CPU::cycle_count_type next_boost_time;
+
+            // Totals over the finished processes for the shutdown report
+            Process::process_id_type finished_process_count;
+            CPU::cycle_count_type total_turnaround_time;
+            CPU::cycle_count_type total_waiting_time;
+            PageTable::size_type total_page_table_size; // In bytes
+
+            CPU::cycle_count_type busy_time; // Cycles spent in processes
+            unsigned long long steal_count;
+
+            result_list_type results;
+
+            unsigned int random_state; // For the choice of a victim
+
+            Processor(unsigned int id, Core &core, ProcessHeap::Order order,
+                      FrameAllocator &frame_allocator);
+            ~Processor();
+        };
+
+        typedef std::vector<std::unique_ptr<Processor> > processor_list_type;
 
         Board board;
 
-        process_list_type processes;
-        process_priorities_type priorities;
+        processor_list_type processors;
 
         Scheduler scheduler;
 
-		Memory::page_table_type *page_table;
+        // An idle kernel, the board is reused by every `Run`
+        Kernel(unsigned int core_count = 1,
+               Memory::ram_size_type ram_size = Memory::DEFAULT_RAM_SIZE,
+               Memory::ram_size_type page_size = Memory::DEFAULT_PAGE_SIZE,
+               SwapSpace::size_type swap_size = SwapSpace::DEFAULT_SIZE);
 
+        // Runs the executables, then dumps the trace and prints the report
         Kernel(
           Scheduler scheduler,
           //std::vector<Memory::ram_type> executables_paths
-          std::vector<std::string> executables_paths
+          std::vector<std::string> executables_paths,
+          quantum_list_type quanta = quantum_list_type(),
+          unsigned int core_count = 1,
+          Memory::ram_size_type ram_size = Memory::DEFAULT_RAM_SIZE,
+          Memory::ram_size_type page_size = Memory::DEFAULT_PAGE_SIZE,
+          SwapSpace::size_type swap_size = SwapSpace::DEFAULT_SIZE,
+          Replacement replacement = Clock,
+          CPU::cycle_count_type working_set_window = DEFAULT_WORKING_SET_WINDOW
         );
         virtual ~Kernel();
 
-        void CreateProcess(const std::string &name);
-        Memory::vmem_size_type VirtualMemoryToPhysical(Memory::ram_size_type previous_index);
+        // Loads the executables into the cleared board and runs them until
+        //  all of them finish (or the board is stopped). The processes and
+        //  the statistics of the previous run are discarded.
+        void Run(Scheduler scheduler,
+                 const std::vector<std::string> &executables_paths,
+                 const quantum_list_type &quanta = quantum_list_type(),
+                 Replacement replacement = Clock,
+                 CPU::cycle_count_type working_set_window = DEFAULT_WORKING_SET_WINDOW);
+
+        // Finished processes of the last run ordered by id
+        result_list_type Results() const;
+
+        // Number of processes created by the last run
+        Process::process_id_type ProcessCount() const
+        {
+            return _last_issued_process_id;
+        }
+
+        // Statistics of the last run
+        void Report(std::ostream &output) const;
+
+        // Loads the image into the memory. The process is not scheduled on
+        //  any core yet. Returns NULL on failure.
+        Process *CreateProcess(const std::string &name);
         Memory::ram_size_type AllocateMemory(Memory::ram_size_type units);
         void FreeMemory(Memory::ram_size_type physical_memory_index);
 
     private:
-        static const unsigned int _MAX_CYCLES_BEFORE_PREEMPTION = 5;
+        // All processes of the multilevel feedback queue move back to the
+        //  first level this often
+        static const CPU::cycle_count_type _BOOST_PERIOD = 500;
+
+        // Returned by `AllocateMemory` when there is no free block
+        static const Memory::ram_size_type _INVALID_MEMORY_POSITION = 0;
+
+        // Processes in the run queue of a core of a multi-core board, the
+        //  rest stays in the backlog and can be stolen by other cores
+        static const RunQueue::size_type _ADMISSION_WINDOW = 4;
 
         Process::process_id_type _last_issued_process_id;
-		    process_list_type::size_type _current_process_index;
-        Memory::ram_type::size_type _last_ram_position;
-        unsigned int _cycles_passed_after_preemption;
 
-        Memory::ram_size_type _free_physical_memory_index;
+        quantum_list_type _quanta;
+        RunQueue::size_type _admission_window;
+
+        Replacement _replacement;
+        CPU::cycle_count_type _working_set_window;
+
+        bool _is_board_used; // The board has to be reset before a run
+
+        // Cores that still have processes and those of them that wait for a
+        //  frame. The others return their cached frames while any core
+        //  waits. Once every busy core waits, no frame is released again.
+        std::atomic<unsigned int> _busy_core_count;
+        std::atomic<unsigned int> _frame_waiter_count;
+
+        std::mutex _memory_mutex; // Guards the free list of the kernel heap
+
+        // Program image in the kernel heap, processes with identical images
+        //  share one copy
+        struct SharedImage
+        {
+            std::shared_ptr<const Executable> executable; // Loaded from
+            Process::process_id_type reference_count;
+
+            // Frames with the initial contents of the pages of the data
+            //  section, mapped copy-on-write into every process
+            Memory::page_table_size_type first_data_page;
+            std::vector<Memory::page_entry_type> data_frames;
+        };
+
+        typedef std::map<Memory::ram_size_type, SharedImage> image_map_type;
+        typedef std::unordered_multimap<std::size_t, Memory::ram_size_type>
+                    image_index_type;
+
+        image_map_type _images;       // By address
+        image_index_type _image_index; // Addresses by the hash of the image
+        std::mutex _image_mutex;      // Guards both, taken before
+                                      //  `_memory_mutex`
+
+        Process::process_id_type _shared_image_count; // Processes of the last
+                                                      //  run that reused an
+                                                      //  image
+
+        // Frame of zeroes mapped copy-on-write for pages that were read
+        //  before they were ever written, `Memory::INVALID_PAGE` if the RAM
+        //  has no frame to spare
+        Memory::page_entry_type _zero_frame;
+
+        // First fit in the free list, `_INVALID_MEMORY_POSITION` if no block
+        //  is large enough
+        Memory::ram_size_type AllocateFreeBlock(Memory::ram_size_type units);
+
+        // Inserts a block into the free list and merges it with the free
+        //  neighbours
+        void LinkFreeBlock(Memory::ram_size_type block);
+
+        // Cuts the whole frames out of the free blocks and returns them to
+        //  the frame allocator, the frame 0 stays with the heap
+        void ReleaseFreeFrames();
+
+        // Sets the timer and software interrupt handlers of the scheduler
+        //  on the core of the processor
+        void InstallHandlers(Processor &processor);
+
+        // Saves the context of the running process and moves it to the back
+        //  of the ready list
+        void Preempt(Processor &processor);
+
+        // Loads the context of the process and marks it as running, stops
+        //  the core and returns its cached frames if there is no process
+        void Dispatch(Processor &processor, Process *process);
+
+        // Unloads the running process and frees its memory
+        void Exit(Processor &processor);
+
+        // Copies the code into the kernel heap and the data into frames or
+        //  returns the address of an identical image that is already
+        //  loaded, `_INVALID_MEMORY_POSITION` if there is no memory left.
+        //  The data pages are mapped copy-on-write into the page table.
+        Memory::ram_size_type LoadImage(const std::shared_ptr<const Executable> &executable,
+                                        Memory::page_table_type &page_table);
+
+        // Frees the image and its data frames once no process uses it
+        void ReleaseImage(Memory::ram_size_type address);
+
+        // Maps the data frames of the image copy-on-write
+        void MapData(const SharedImage &image, Memory::page_table_type &page_table);
+
+        // Returns the data frames of the image to the frame allocator
+        void ReleaseFrames(SharedImage &image);
+
+        // Resolves a page fault of the running process. A read of a page
+        //  that was never written maps the zero frame copy-on-write, a write
+        //  to such a page gets a private copy. Other pages get a frame and
+        //  are read back from the swap space if they were evicted. If the
+        //  core has no page to evict, the process waits for other cores to
+        //  release frames: the page stays unmapped and the instruction
+        //  faults again. Returns false if there is no swap space left or
+        //  every busy core waits.
+        bool PageIn(Processor &processor, Memory::page_table_size_type page,
+                    bool write);
+
+        // Picks a resident page by the replacement policy, writes it to the
+        //  swap space if needed and unmaps it. Returns the freed frame or
+        //  `Memory::INVALID_PAGE`, the page stays in the ring at
+        //  `clock_hand` to be replaced.
+        Memory::page_entry_type Evict(Processor &processor);
+
+        // Moves the clock hand to the page to replace
+        void SelectVictim(Processor &processor);
+
+        // Returns the frames and swap slots of the process
+        void ReleasePages(Processor &processor, Process &process);
+
+        // CPU time of the process including the current burst
+        CPU::cycle_count_type VirtualTime(const Processor &processor,
+                                          const Process &process) const;
+
+        // Moves processes from the backlog into the run queue of the core,
+        //  steals one from another core if there is nothing else to run
+        void Admit(Processor &processor);
+
+        // Takes a process from the backlog of a random other core. Returns
+        //  NULL once all backlogs are empty.
+        Process *Steal(Processor &processor);
+
+        // Prepares the image of the process for the core if it was last run
+        //  or loaded for another one
+        void Migrate(Processor &processor, Process &process);
+
+        // Arms the timer with the quantum of the level of the running process
+        void ArmQuantum(Processor &processor);
+
+        // Moves every process of the multilevel feedback queue to the first
+        //  level if the boost period has passed
+        void BoostIfDue(Processor &processor);
     };
 }
 
@@ -2,9 +2,11 @@
 #define Memory_H
 
 #include <vector>
-#include <stack>
 #include <utility>
 
+#include "frame_allocator.h"
+#include "page_table.h"
+
 namespace svm
 {
     class Memory
@@ -16,32 +18,69 @@ namespace svm
         typedef ram_size_type vmem_size_type;
         typedef vmem_size_type page_entry_type;
 
-        typedef std::vector<page_entry_type>  page_table_type;
+        typedef PageTable page_table_type;
         typedef page_table_type::size_type page_table_size_type;
 
         typedef std::pair<page_table_size_type, ram_size_type> page_index_offset_pair_type;
 
-        static const ram_size_type RAM_SIZE = 0xFFFF; // 64 KB
-        static const ram_size_type PAGE_SIZE = 0x80;  // 128 B
+        typedef unsigned int address_space_type;
+
+        // Sizes are in cells (ints). The page size is rounded up to a power
+        //  of two, the RAM size to whole pages.
+        static const ram_size_type DEFAULT_RAM_SIZE = 0x10000; // 64K cells
+        static const ram_size_type DEFAULT_PAGE_SIZE = 0x80;   // 128 cells
+        static const ram_size_type MIN_PAGE_SIZE = 0x8; // Room for the flags
+                                                        //  of `PageTable`
 
         static const ram_size_type INVALID_PAGE = 0;
 
         ram_type ram;
-        page_table_type* page_table;
+        FrameAllocator frames; // Whole pages of the RAM
 
-        Memory();
+        Memory(ram_size_type ram_size = DEFAULT_RAM_SIZE,
+               ram_size_type page_size = DEFAULT_PAGE_SIZE);
         virtual ~Memory();
 
-        static page_table_type* CreateEmptyPageTable();
+        ram_size_type PageSize() const
+        {
+            return _page_mask + 1;
+        }
+
+        // Empty page table of a process, the virtual address space has the
+        //  size of the RAM
+        page_table_type* CreateEmptyPageTable() const
+        {
+            return CreateEmptyPageTable(ram.size());
+        }
+
+        // Empty page table for a virtual address space of `size` cells
+        page_table_type* CreateEmptyPageTable(vmem_size_type size) const;
+
+        // Zeroes the RAM and frees every frame
+        void Reset();
+
+        page_index_offset_pair_type PageOffsetForVirtual(vmem_size_type address) const
+        {
+            return std::make_pair(static_cast<page_table_size_type>(address >> _page_shift),
+                                  static_cast<ram_size_type>(address & _page_mask));
+        }
 
-        page_index_offset_pair_type PageOffsetForVirtual(vmem_size_type address);
+        // Can be called from any core, see also the per-CPU `FrameCache`
+        page_entry_type AcquireFrame()
+        {
+            return frames.Acquire();
+        }
 
-        page_entry_type AcquireFrame();
-        void ReleaseFrame(page_entry_type page);
+        void ReleaseFrame(page_entry_type page)
+        {
+            frames.Release(page);
+        }
 
     private:
+        unsigned int _page_shift;
+        ram_size_type _page_mask;
 
-		std::stack<page_entry_type> free_frames;
+        static unsigned int PageShift(ram_size_type page_size);
     };
 }
 
@@ -0,0 +1,157 @@
+#ifndef PAGE_TABLE_H
+#define PAGE_TABLE_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace svm
+{
+    // Multi-Level Page Table
+    //
+    // Radix tree over the page number with `FANOUT` slots per node. The
+    //  number of levels follows the size of the address space (one level
+    //  covers 512 pages, two levels 256K pages, ...). Nodes are allocated
+    //  on the first mapping below them, so the table of a small program
+    //  takes a single leaf whatever the size of the RAM. A leaf holds 512
+    //  entries in one contiguous block (4 KiB with 64-bit entries), and the
+    //  last leaf used is remembered, so walks within one region of memory
+    //  skip the upper levels.
+    //
+    // Frames are page aligned, so the low bits of an entry hold the
+    //  reference, dirty and copy-on-write bits of the page (pages have at
+    //  least 8 cells).
+    //
+    // A table is only used by the core that runs its process.
+    class PageTable
+    {
+        public:
+            typedef std::size_t size_type;
+            typedef std::size_t entry_type; // Physical address of a frame
+                                            //  and the flags below
+
+            static const entry_type INVALID_ENTRY = 0;
+
+            static const entry_type REFERENCED    = 0x1; // Read or written
+            static const entry_type DIRTY         = 0x2; // Written
+            static const entry_type COPY_ON_WRITE = 0x4; // Shared frame, a
+                                                         //  write faults
+            static const entry_type FLAG_MASK     = REFERENCED | DIRTY |
+                                                    COPY_ON_WRITE;
+
+            static const unsigned int LEVEL_BITS = 9;
+            static const size_type FANOUT = static_cast<size_type>(1) << LEVEL_BITS;
+
+            PageTable(size_type page_count);
+            virtual ~PageTable();
+
+            // Frame of the page or `INVALID_ENTRY` if it is not mapped
+            entry_type Lookup(size_type page)
+            {
+                if ((page >> LEVEL_BITS) == _last_leaf_index &&
+                        _last_leaf != NULL) {
+                    return _last_leaf->entries[page & (FANOUT - 1)];
+                }
+
+                return Walk(page);
+            }
+
+            // Returns false if the page is outside of the address space.
+            //  Mapping a page to `INVALID_ENTRY` unmaps it.
+            bool Map(size_type page, entry_type frame);
+
+            // Entry of a mapped page for updates of its flags, NULL if the
+            //  page is not mapped
+            entry_type *Find(size_type page)
+            {
+                entry_type *entry;
+                if ((page >> LEVEL_BITS) == _last_leaf_index &&
+                        _last_leaf != NULL) {
+                    entry = &_last_leaf->entries[page & (FANOUT - 1)];
+                } else {
+                    if (page >= _page_count) {
+                        return NULL;
+                    }
+                    Node *leaf = FindLeaf(page, false);
+                    if (leaf == NULL) {
+                        return NULL;
+                    }
+                    entry = &leaf->entries[page & (FANOUT - 1)];
+                }
+
+                return *entry != INVALID_ENTRY ? entry : NULL;
+            }
+
+            static entry_type FrameOf(entry_type entry)
+            {
+                return entry & ~FLAG_MASK;
+            }
+
+            // Calls `visitor(page, entry)` for every mapped page
+            template <typename Visitor>
+            void ForEachMapped(Visitor visitor) const
+            {
+                if (_root) {
+                    Visit(*_root, _levels - 1, 0, visitor);
+                }
+            }
+
+            size_type PageCount() const
+            {
+                return _page_count;
+            }
+
+            // Host memory taken by the nodes, in bytes
+            size_type MemoryUsage() const;
+
+        private:
+            struct Node
+            {
+                std::vector<entry_type> entries;              // Leaves
+                std::vector<std::unique_ptr<Node> > children; // Upper levels
+
+                Node(bool is_leaf);
+            };
+
+            size_type _page_count;
+            unsigned int _levels;
+
+            std::unique_ptr<Node> _root;
+            size_type _node_count;
+
+            size_type _last_leaf_index; // Page number >> LEVEL_BITS
+            Node *_last_leaf;
+
+            PageTable(const PageTable &);
+            PageTable &operator=(const PageTable &);
+
+            entry_type Walk(size_type page);
+
+            // Leaf of the page, created along the way if `create` is set
+            Node *FindLeaf(size_type page, bool create);
+
+            template <typename Visitor>
+            static void Visit(const Node &node, unsigned int level,
+                              size_type first_page, Visitor &visitor)
+            {
+                if (level == 0) {
+                    for (size_type i = 0; i < FANOUT; ++i) {
+                        if (node.entries[i] != INVALID_ENTRY) {
+                            visitor(first_page + i, node.entries[i]);
+                        }
+                    }
+
+                    return;
+                }
+
+                for (size_type i = 0; i < FANOUT; ++i) {
+                    if (node.children[i]) {
+                        Visit(*node.children[i], level - 1,
+                              first_page + (i << (LEVEL_BITS * level)), visitor);
+                    }
+                }
+            }
+    };
+}
+
+#endif
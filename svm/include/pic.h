@@ -1,7 +1,7 @@
 #ifndef PIC_H
 #define PIC_H
 
-#include <functional>
+#include <cstddef>
 
 namespace svm
 {
@@ -9,38 +9,163 @@ namespace svm
     //
     // IRQ: Interrupt Request
     // ISR: Interrupt Service Routine
+    //
+    // Interrupt service routines are kept in a flat vector of plain function
+    //  pointers with a context argument. Lambdas and member functions are
+    //  installed through trampolines that call them directly, so the body of
+    //  a kernel handler is inlined into its trampoline and raising an
+    //  interrupt costs a single indirect call.
+    //
+    // Hardware interrupt requests (`Raise`) are latched into a pending
+    //  bitmask in the `Deferred` mode and delivered by the board between
+    //  instructions (`DeliverPending`). Requests that arrive while a
+    //  handler runs coalesce with the pending one instead of nesting.
+    //  Lower vectors have higher priority. Software interrupts and
+    //  exceptions (`Interrupt`) are always delivered synchronously.
     class PIC
     {
         public:
-            typedef std::function<void()> isr_type;
+            typedef void (*isr_type)(void *context);
+
+            enum DeliveryMode
+            {
+                Immediate, // `Raise` calls the ISR right away
+                Deferred   // `Raise` only latches the request
+            };
+
+            static const unsigned int VECTOR_COUNT = 17;
 
             // Hardware Interrupts (interrupt service routines that are
             //  called for incoming hardware events)
 
-            isr_type isr_0; // IRQ 0: Timer
-            isr_type isr_1; // IRQ 1: Keyboard
-            isr_type isr_2; // IRQ 2: ...TBD
+            static const unsigned int TIMER_VECTOR    = 0; // IRQ 0
+            static const unsigned int KEYBOARD_VECTOR = 1; // IRQ 1
+                                                           // IRQ 2: ...TBD
 
             // Software Interrupts (interrupt service routines that are
-            //  called by executing the 'int' CPU instruction)
-
-            isr_type isr_3; // The kernel should decide how to use them
-            isr_type isr_4;
-            isr_type isr_5;
-            isr_type isr_6;
-            isr_type isr_7;
-            isr_type isr_8;
-            isr_type isr_9;
-            isr_type isr_10;
-            isr_type isr_11;
-            isr_type isr_12;
-            isr_type isr_13;
-            isr_type isr_14;
-            isr_type isr_15;
-            isr_type isr_16;
+            //  called by executing the 'int' CPU instruction, see
+            //  `SoftwareInterruptVector`)
+            //
+            // Vectors 3, 5...16. The kernel should decide how to use them.
+
+            // Exceptions
+
+            static const unsigned int PAGE_FAULT_VECTOR = 4;
+
+            static const unsigned int INVALID_VECTOR = VECTOR_COUNT;
+
+            DeliveryMode delivery_mode;
 
             PIC();
             virtual ~PIC();
+
+            // Calls the interrupt service routine of the vector
+            void Interrupt(unsigned int vector)
+            {
+                const Entry &entry = _vectors[vector];
+                entry.isr(entry.context);
+            }
+
+            // Interrupt request from a device
+            void Raise(unsigned int vector)
+            {
+                if (delivery_mode == Immediate) {
+                    Interrupt(vector);
+                } else {
+                    _pending |= 1u << vector;
+                }
+            }
+
+            // Whether any unmasked request is waiting for delivery
+            bool HasPending() const
+            {
+                return (_pending & ~_masked) != 0;
+            }
+
+            // Delivers the pending unmasked requests in priority order.
+            //  Does nothing when called from inside a delivered handler.
+            void DeliverPending();
+
+            // Drops the pending requests and the installed ISRs, unmasks
+            //  all vectors
+            void Reset();
+
+            void Mask(unsigned int vector);
+            void Unmask(unsigned int vector);
+            bool IsMasked(unsigned int vector) const;
+
+            void SetISR(unsigned int vector, isr_type isr,
+                        void *context = NULL);
+
+            // Installs a copy of a callable object (e.g., a lambda)
+            template <typename Handler>
+            void SetISR(unsigned int vector, const Handler &handler)
+            {
+                Install(vector, &PIC::Invoke<Handler>,
+                        new Handler(handler), &PIC::Destroy<Handler>);
+            }
+
+            // Installs a member function of an object owned by the caller
+            template <typename Object, void (Object::*Method)()>
+            void SetISR(unsigned int vector, Object *object)
+            {
+                Install(vector, &PIC::InvokeMethod<Object, Method>,
+                        object, NULL);
+            }
+
+            // `int 1` maps to the vector 3, `int 2` and above skip the page
+            //  fault vector: `int n` maps to `n + 3`. Returns
+            //  `INVALID_VECTOR` for numbers without a vector.
+            static unsigned int SoftwareInterruptVector(int number)
+            {
+                return number == 1 ? 3 :
+                       number > 1 && number + 3 < static_cast<int>(VECTOR_COUNT) ?
+                           static_cast<unsigned int>(number + 3) :
+                           INVALID_VECTOR;
+            }
+
+        private:
+            typedef void (*destructor_type)(void *context);
+
+            struct Entry
+            {
+                isr_type isr;
+                void *context;
+                destructor_type destructor; // Releases an owned context
+            };
+
+            Entry _vectors[VECTOR_COUNT];
+
+            unsigned int _pending; // One bit per vector
+            unsigned int _masked;
+            bool _in_service;
+
+            PIC(const PIC &);
+            PIC &operator=(const PIC &);
+
+            void Install(unsigned int vector, isr_type isr, void *context,
+                         destructor_type destructor);
+            void Release(Entry &entry);
+
+            static void Ignore(void *context);
+
+            template <typename Handler>
+            static void Invoke(void *context)
+            {
+                (*static_cast<Handler *>(context))();
+            }
+
+            template <typename Handler>
+            static void Destroy(void *context)
+            {
+                delete static_cast<Handler *>(context);
+            }
+
+            template <typename Object, void (Object::*Method)()>
+            static void InvokeMethod(void *context)
+            {
+                (static_cast<Object *>(context)->*Method)();
+            }
     };
 }
 
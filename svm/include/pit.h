@@ -1,27 +1,77 @@
 #ifndef PIT_H
 #define PIT_H
 
+#include <limits>
+
 #include "pic.h"
 
 namespace svm
 {
     // Hardware Timer (Programmable Interval Timer)
+    //
+    // Counts virtual time in CPU cycles. In the periodic mode the timer
+    //  interrupt is raised every `frequency` cycles. In the one-shot mode it
+    //  is raised once, when the deadline programmed with `Arm` is reached;
+    //  without a deadline the timer stays silent.
+    //
+    // The board does not tick the timer for every instruction. It asks for
+    //  the distance to the next interrupt, runs that many cycles and reports
+    //  them with `Advance`.
     class PIT
     {
         public:
             typedef unsigned int frequency_type;
+            typedef unsigned long long cycle_count_type;
+
+            enum Mode
+            {
+                Periodic,
+                OneShot
+            };
 
             static const frequency_type DEFAULT_FREQUENCY = 1;
 
-            frequency_type frequency;
+            static const cycle_count_type NO_DEADLINE =
+                std::numeric_limits<cycle_count_type>::max();
+
+            frequency_type frequency; // Used in the periodic mode
 
             PIT(PIC &pic);
             virtual ~PIT();
 
-            void Tick(); // Calls isr_0 periodically
+            void Tick(); // Advances the time by one cycle, raises the timer
+                         //  interrupt when it is due
+
+            // Switches to the one-shot mode with the interrupt raised on the
+            //  `cycles`-th tick from now
+            void Arm(cycle_count_type cycles);
+
+            // Switches to the one-shot mode without a deadline
+            void Disarm();
+
+            Mode GetMode() const;
+
+            // Back to the periodic mode at the time 0
+            void Reset();
+
+            // Virtual time passed since the start, in cycles
+            cycle_count_type Now() const;
+
+            // Number of ticks up to and including the next one that raises
+            //  the timer interrupt (at least one, `NO_DEADLINE` if there is
+            //  none)
+            cycle_count_type CyclesUntilInterrupt() const;
+
+            // Accounts for `cycles` ticks that do not reach the next interrupt
+            void Advance(cycle_count_type cycles);
 
         private:
-            frequency_type _passed_cycles_count;
+            Mode _mode;
+
+            cycle_count_type _now;
+            cycle_count_type _deadline; // One-shot mode
+
+            frequency_type _passed_cycles_count; // Periodic mode
 
             PIC &_pic;
     };
@@ -1,8 +1,12 @@
 #ifndef PROCESS_H
 #define PROCESS_H
 
+#include <cstddef>
+#include <unordered_map>
+
 #include "cpu.h"
 #include "memory.h"
+#include "swap_space.h"
 
 namespace svm
 {
@@ -17,6 +21,10 @@ namespace svm
         typedef unsigned int process_id_type;
         typedef unsigned short process_priority_type;
 
+        typedef std::unordered_map<Memory::page_table_size_type,
+                                   SwapSpace::slot_type> swap_map_type;
+        typedef unsigned long long counter_type;
+
         process_id_type id;
 
         Registers registers;
@@ -29,14 +37,59 @@ namespace svm
 
         Memory::ram_size_type sequential_instruction_count;
 
+        // Predicted length of the next CPU burst, starts with the static
+        //  instruction count and follows the observed bursts
+        CPU::cycle_count_type predicted_burst;
+
+        // Accounting, in cycles of the board time
+        CPU::cycle_count_type arrival_time;
+        CPU::cycle_count_type burst_start_time;
+        CPU::cycle_count_type cpu_time;
+
         Memory::page_table_type *page_table;
 
+        // Copies of pages in the swap space. A copy stays valid while the
+        //  page is resident and clean, so a clean page is evicted without
+        //  writing it again.
+        swap_map_type swap_slots;
+
+        counter_type page_fault_count;
+        counter_type swap_in_count;  // Pages read from the swap space
+        counter_type swap_out_count; // Pages written to the swap space
+        counter_type copy_on_write_count; // Shared pages copied on a write
+
+        unsigned int _DYNAMIC_MAX_CYCLES_BEFORE_PREEMPTION;
+
+        unsigned int level; // Level of the multilevel feedback queue
+
+        // Core the image was last prepared for (translated) and run on. A
+        //  process is only moved to another core before it started.
+        unsigned int cpu;
+
+        // Links of the run queue list of the current state, see `RunQueue`
+        Process *previous;
+        Process *next;
+
+        std::size_t heap_index; // Position in the `ProcessHeap` of ready
+                                //  processes
+
+        // Takes over the page table
         Process(process_id_type id, Memory::ram_size_type memory_start_position,
-                                    Memory::ram_size_type memory_end_position);
+                                    Memory::ram_size_type memory_end_position,
+                                    Memory::page_table_type *page_table);
 
         virtual ~Process();
         void updateCycles();
-        bool operator<(const Process &anotherProcess) const;
+
+        // Accounts for a CPU burst that ended and refines the prediction
+        //  of the next one with exponential averaging
+        void EndBurst(CPU::cycle_count_type time);
+
+    private:
+        // Processes own their page tables and are linked into the run queue
+        //  in place, they are never copied
+        Process(const Process &);
+        Process &operator=(const Process &);
     };
 }
 
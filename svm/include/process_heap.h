@@ -0,0 +1,100 @@
+#ifndef PROCESS_HEAP_H
+#define PROCESS_HEAP_H
+
+#include <cstddef>
+#include <vector>
+
+#include "process.h"
+
+namespace svm
+{
+    // Indexed Heap of Processes
+    //
+    // Binary heap ordered by the highest priority or by the shortest
+    //  predicted CPU burst. Every process in the heap knows its position
+    //  (`Process::heap_index`), so it can be removed or have its key changed
+    //  in place in O(log n) without searching. Processes with equal keys come
+    //  out in the order they were pushed.
+    class ProcessHeap
+    {
+        public:
+            typedef std::size_t size_type;
+
+            enum Order
+            {
+                HighestPriority,
+                ShortestBurst
+            };
+
+            static const size_type INVALID_INDEX = static_cast<size_type>(-1);
+
+            ProcessHeap(Order order = HighestPriority);
+            virtual ~ProcessHeap();
+
+            void Push(Process &process);
+            void Remove(Process &process);
+
+            // Moves the process after a change of its key
+            void Update(Process &process);
+
+            // First process in the order or NULL
+            Process *Top() const
+            {
+                return _entries.empty() ? NULL : _entries.front().process;
+            }
+
+            static bool Contains(const Process &process)
+            {
+                return process.heap_index != INVALID_INDEX;
+            }
+
+            size_type Size() const
+            {
+                return _entries.size();
+            }
+
+            bool IsEmpty() const
+            {
+                return _entries.empty();
+            }
+
+        private:
+            typedef unsigned long long sequence_type;
+
+            struct Entry
+            {
+                Process *process;
+                sequence_type sequence; // Order of pushes among equals
+            };
+
+            Order _order;
+
+            std::vector<Entry> _entries;
+            sequence_type _next_sequence;
+
+            ProcessHeap(const ProcessHeap &);
+            ProcessHeap &operator=(const ProcessHeap &);
+
+            bool IsBefore(const Entry &first, const Entry &second) const
+            {
+                const Process &a = *first.process;
+                const Process &b = *second.process;
+
+                if (_order == ShortestBurst) {
+                    if (a.predicted_burst != b.predicted_burst) {
+                        return a.predicted_burst < b.predicted_burst;
+                    }
+                } else if (a.priority != b.priority) {
+                    return a.priority > b.priority;
+                }
+
+                return first.sequence < second.sequence;
+            }
+
+            void SiftUp(size_type index);
+            void SiftDown(size_type index);
+            void Place(const Entry &entry, size_type index);
+    };
+}
+
+#endif
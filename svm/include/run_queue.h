@@ -0,0 +1,180 @@
+#ifndef RUN_QUEUE_H
+#define RUN_QUEUE_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "process.h"
+#include "process_heap.h"
+
+namespace svm
+{
+    // Intrusive List of Processes
+    //
+    // Links processes through their own `previous` and `next` pointers, so
+    //  adding and removing a process never allocates or copies it. A process
+    //  can be in one list at a time.
+    class ProcessList
+    {
+        public:
+            typedef std::size_t size_type;
+
+            ProcessList();
+            virtual ~ProcessList();
+
+            void PushBack(Process &process);
+            void PushFront(Process &process);
+            void Remove(Process &process);
+
+            Process *PopFront();
+
+            Process *Front() const
+            {
+                return _front;
+            }
+
+            // Next process after `process` in the list or NULL
+            static Process *Next(const Process &process)
+            {
+                return process.next;
+            }
+
+            size_type Size() const
+            {
+                return _size;
+            }
+
+            bool IsEmpty() const
+            {
+                return _size == 0;
+            }
+
+        private:
+            Process *_front;
+            Process *_back;
+            size_type _size;
+
+            ProcessList(const ProcessList &);
+            ProcessList &operator=(const ProcessList &);
+    };
+
+    // Run Queue
+    //
+    // Owns the processes and keeps every one of them in the list of its
+    //  state (ready, running or blocked). Processes never move in memory, so
+    //  a process id or a reference stays valid until the process is
+    //  terminated. List operations are O(1).
+    //
+    // Ready processes are split into levels (`Process::level`, the first
+    //  one is 0) for the multilevel feedback queue. Other schedulers keep
+    //  every process on the first level.
+    //
+    // Ready processes are also kept in a heap by priority or by the
+    //  predicted CPU burst. Entering or leaving the ready state and changing
+    //  a priority cost O(log n).
+    class RunQueue
+    {
+        public:
+            typedef Process::process_id_type handle_type;
+            typedef std::size_t size_type;
+
+            static const unsigned int LEVEL_COUNT = 8;
+
+            RunQueue(ProcessHeap::Order order = ProcessHeap::HighestPriority);
+            virtual ~RunQueue();
+
+            // Takes the ownership of a new process and appends it to the
+            //  ready list
+            Process &Add(Process *process);
+
+            // Process with the id or NULL if there is no such process
+            Process *Find(handle_type id) const;
+
+            // Moves the process to the back of the list of the state
+            void SetState(Process &process, Process::States state);
+
+            // Removes the process from its list and destroys it
+            void Terminate(Process &process);
+
+            // Changes the priority in place, ready processes are reordered
+            void SetPriority(Process &process,
+                             Process::process_priority_type priority);
+
+            // Moves a ready process to the back of another level
+            void SetLevel(Process &process, unsigned int level);
+
+            const ProcessList &Ready(unsigned int level = 0) const
+            {
+                return _ready[level];
+            }
+
+            // Front of the first non-empty ready level or NULL
+            Process *NextReady() const
+            {
+                if (_ready_levels == 0) {
+                    return NULL;
+                }
+
+                unsigned int level = 0;
+                while ((_ready_levels & (1u << level)) == 0) {
+                    ++level;
+                }
+
+                return _ready[level].Front();
+            }
+
+            size_type ReadyCount() const
+            {
+                return _ready_count;
+            }
+
+            const ProcessList &Blocked() const
+            {
+                return _blocked;
+            }
+
+            // Ready process with the highest priority or the shortest
+            //  predicted burst (depending on the order) or NULL
+            Process *Preferred() const
+            {
+                return _ready_heap.Top();
+            }
+
+            // The running process or NULL
+            Process *Running() const
+            {
+                return _running.Front();
+            }
+
+            size_type Size() const
+            {
+                return _ready_count + _running.Size() + _blocked.Size();
+            }
+
+            bool IsEmpty() const
+            {
+                return Size() == 0;
+            }
+
+        private:
+            std::vector<std::unique_ptr<Process> > _processes; // By id
+
+            ProcessList _ready[LEVEL_COUNT];
+            unsigned int _ready_levels; // One bit per non-empty level
+            size_type _ready_count;
+
+            ProcessList _running;
+            ProcessList _blocked;
+
+            ProcessHeap _ready_heap;
+
+            RunQueue(const RunQueue &);
+            RunQueue &operator=(const RunQueue &);
+
+            void Link(Process &process);
+            void Unlink(Process &process);
+    };
+}
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef SEQUENCE_PROFILE_H
+#define SEQUENCE_PROFILE_H
+
+#include <cstddef>
+#include <ostream>
+#include <unordered_map>
+
+namespace svm
+{
+    // Instruction Sequence Profile
+    //
+    // Counts pairs and triples of consecutively executed opcodes. Filled by
+    //  `CPU::Run` in builds with `SVM_PROFILE_SEQUENCES` to pick the
+    //  sequences worth fusing into superinstructions.
+    class SequenceProfile
+    {
+        public:
+            typedef unsigned long long counter_type;
+
+            SequenceProfile();
+            virtual ~SequenceProfile();
+
+            void Record(int opcode);
+            void Report(std::ostream &stream, std::size_t limit = 10) const;
+
+            bool IsEmpty() const;
+
+        private:
+            typedef std::unordered_map<unsigned int, counter_type>
+                        sequences_type;
+
+            sequences_type _pairs;
+            sequences_type _triples;
+
+            counter_type _recorded;
+            unsigned int _previous; // Last two opcodes, one byte each
+
+            static void ReportSequences(std::ostream &stream,
+                                        const sequences_type &sequences,
+                                        unsigned int length,
+                                        counter_type total,
+                                        std::size_t limit);
+    };
+}
+
+#endif
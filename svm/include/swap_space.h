@@ -0,0 +1,63 @@
+#ifndef SWAP_SPACE_H
+#define SWAP_SPACE_H
+
+#include <cstddef>
+
+#include "frame_allocator.h"
+
+namespace svm
+{
+    // Backing Store
+    //
+    // Slots of one page each for pages that were evicted from the RAM. The
+    //  slots live in an anonymous memory mapping of the host, so the host
+    //  only commits the slots that were written. Hosts without `mmap` get
+    //  an uninitialized `int` array from `new[]` instead.
+    //  Free slots are kept in a `FrameAllocator` bitmap, slots are numbered
+    //  by their offset in cells and the slot at the offset 0 is never
+    //  handed out (`INVALID_SLOT`).
+    class SwapSpace
+    {
+        public:
+            typedef FrameAllocator::frame_type slot_type;
+            typedef FrameAllocator::size_type size_type;
+
+            static const slot_type INVALID_SLOT = FrameAllocator::INVALID_FRAME;
+
+            static const size_type DEFAULT_SIZE = 0x10000; // 64K cells
+
+            // Sizes in cells, the size is rounded up to whole pages
+            SwapSpace(size_type size, size_type page_size);
+            virtual ~SwapSpace();
+
+            slot_type Acquire(); // INVALID_SLOT if the swap space is full
+            void Release(slot_type slot);
+
+            void Write(slot_type slot, const int *page);
+            void Read(slot_type slot, int *page) const;
+
+            // Frees every slot
+            void Reset();
+
+            size_type SlotCount() const
+            {
+                return _slots.FrameCount() - 1;
+            }
+
+            size_type UsedCount() const
+            {
+                return _slots.UsedCount() - 1;
+            }
+
+        private:
+            FrameAllocator _slots;
+
+            int *_cells;
+            size_type _cell_count;
+
+            SwapSpace(const SwapSpace &);
+            SwapSpace &operator=(const SwapSpace &);
+    };
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef THREADED_CODE_H
+#define THREADED_CODE_H
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#include "memory.h"
+#include "decode_cache.h"
+
+namespace svm
+{
+    // Instruction of a translated program image
+    //
+    // `next` points directly at the instruction executed afterwards (the
+    //  resolved target for `jmp`), or is NULL if it lies outside of the
+    //  image
+    struct ThreadedInstruction
+    {
+        DecodedInstruction instruction;
+        const ThreadedInstruction *next;
+    };
+
+    // Threaded Code
+    //
+    // Program images translated once at load time, keyed by the physical
+    //  address they were loaded at. A translation is dropped as soon as
+    //  anything writes into its range.
+    class ThreadedCode
+    {
+        public:
+            typedef std::vector<ThreadedInstruction> code_type;
+
+            ThreadedCode();
+            virtual ~ThreadedCode();
+
+            // Takes over `code` (emptied) for the image at `address`
+            void Add(Memory::ram_size_type address, code_type &code);
+
+            // Returns the translated instruction at `address` or NULL
+            const ThreadedInstruction *Find(Memory::ram_size_type address)
+            {
+                if (_last != _translations.end() &&
+                        address >= _last->first &&
+                        address < _last->first + _last->second.size() * 2) {
+                    return Instruction(_last, address);
+                }
+
+                return FindTranslation(address);
+            }
+
+            // Drops every translation that overlaps the range, returns
+            //  whether there were any
+            bool Invalidate(Memory::ram_size_type address,
+                            Memory::ram_size_type size = 1)
+            {
+                if (address + size <= _lowest || address >= _highest) {
+                    return false;
+                }
+
+                return InvalidateTranslations(address, size);
+            }
+
+        private:
+            typedef std::map<Memory::ram_size_type, code_type>
+                        translations_type;
+
+            translations_type _translations;
+            translations_type::iterator _last;
+
+            Memory::ram_size_type _lowest;  // Bounds of all translated
+            Memory::ram_size_type _highest; //  ranges
+
+            const ThreadedInstruction *FindTranslation(
+                                           Memory::ram_size_type address);
+            bool InvalidateTranslations(Memory::ram_size_type address,
+                                        Memory::ram_size_type size);
+            void UpdateBounds();
+
+            static const ThreadedInstruction *Instruction(
+                                           translations_type::iterator it,
+                                           Memory::ram_size_type address)
+            {
+                Memory::ram_size_type offset = address - it->first;
+
+                return offset % 2 == 0 ? &it->second[offset / 2] : NULL;
+            }
+    };
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef TLB_H
+#define TLB_H
+
+#include <vector>
+#include <limits>
+
+#include "memory.h"
+
+namespace svm
+{
+    // Translation Lookaside Buffer
+    //
+    // Direct-mapped cache of page table entries. Entries are tagged with the
+    //  address space they belong to, so switching page tables does not
+    //  require a flush. Only valid translations are cached; the kernel has
+    //  to invalidate a page when it changes or removes its mapping.
+    class TLB
+    {
+        public:
+            typedef unsigned long long counter_type;
+
+            // Number of entries, must be a power of two
+            static const Memory::page_table_size_type DEFAULT_SIZE = 0x40;
+
+            counter_type hits;
+            counter_type misses;
+
+            TLB(Memory::page_table_size_type size = DEFAULT_SIZE);
+            virtual ~TLB();
+
+            bool Lookup(Memory::address_space_type address_space,
+                        Memory::page_table_size_type page,
+                        Memory::page_entry_type &frame)
+            {
+                const Entry &entry = _entries[page & _mask];
+                if (entry.address_space == address_space &&
+                        entry.page == page) {
+                    ++hits;
+                    frame = entry.frame;
+
+                    return true;
+                }
+
+                ++misses;
+
+                return false;
+            }
+
+            void Insert(Memory::address_space_type address_space,
+                        Memory::page_table_size_type page,
+                        Memory::page_entry_type frame)
+            {
+                Entry &entry = _entries[page & _mask];
+                entry.address_space = address_space;
+                entry.page = page;
+                entry.frame = frame;
+            }
+
+            void Invalidate(Memory::address_space_type address_space,
+                            Memory::page_table_size_type page);
+            void Flush(Memory::address_space_type address_space);
+            void Flush();
+
+        private:
+            static const Memory::address_space_type _INVALID_ADDRESS_SPACE =
+                std::numeric_limits<Memory::address_space_type>::max();
+
+            struct Entry
+            {
+                Memory::address_space_type address_space;
+                Memory::page_table_size_type page;
+                Memory::page_entry_type frame;
+            };
+
+            std::vector<Entry> _entries;
+            Memory::page_table_size_type _mask;
+    };
+}
+
+#endif
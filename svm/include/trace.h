@@ -0,0 +1,126 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+
+// Compile-time trace levels, see `SVM_TRACE` in CMakeLists.txt
+#define SVM_TRACE_LEVEL_NONE  0
+#define SVM_TRACE_LEVEL_ERROR 1
+#define SVM_TRACE_LEVEL_INFO  2
+#define SVM_TRACE_LEVEL_DEBUG 3
+
+#ifndef SVM_TRACE_LEVEL
+    #define SVM_TRACE_LEVEL SVM_TRACE_LEVEL_INFO
+#endif
+
+namespace svm
+{
+    // Kernel Trace
+    //
+    // Trace records are written into a preallocated ring buffer instead of
+    //  an output stream. A record only keeps a pointer to a static format
+    //  string and up to three integer arguments, so writing one costs a few
+    //  stores and no formatting or allocation. Records are formatted by
+    //  `Dump`, which can be called on exit or periodically from another
+    //  thread. When the ring buffer wraps around before a dump, the oldest
+    //  records are lost and counted.
+    //
+    // Format strings use `{}` as the placeholder for the next argument.
+    //
+    // Use the `SVM_TRACE_*` macros below. Levels above the compile-time
+    //  `SVM_TRACE_LEVEL` expand to nothing, the rest are filtered at run time
+    //  with `SetLevel`.
+    class Trace
+    {
+        public:
+            typedef unsigned long long argument_type;
+            typedef unsigned long long sequence_type;
+
+            enum Level
+            {
+                None  = SVM_TRACE_LEVEL_NONE,
+                Error = SVM_TRACE_LEVEL_ERROR,
+                Info  = SVM_TRACE_LEVEL_INFO,
+                Debug = SVM_TRACE_LEVEL_DEBUG
+            };
+
+            static const std::size_t CAPACITY = 0x1000; // Power of two
+            static const unsigned int MAX_ARGUMENTS = 3;
+
+            static void Write(Level level, const char *format,
+                              argument_type first = 0,
+                              argument_type second = 0,
+                              argument_type third = 0)
+            {
+                if (level > _level.load(std::memory_order_relaxed)) {
+                    return;
+                }
+
+                sequence_type sequence =
+                    _next.fetch_add(1, std::memory_order_relaxed);
+
+                Record &record = _records[sequence & (CAPACITY - 1)];
+                record.level = level;
+                record.format = format;
+                record.arguments[0] = first;
+                record.arguments[1] = second;
+                record.arguments[2] = third;
+                record.sequence.store(sequence + 1, std::memory_order_release);
+            }
+
+            static void SetLevel(Level level);
+            static Level GetLevel();
+
+            // Parses "none", "error", "info" or "debug", returns false for
+            //  anything else
+            static bool ParseLevel(const char *name, Level &level);
+
+            // Formats the records written since the previous dump. Only one
+            //  thread may dump at a time.
+            static void Dump(std::ostream &stream);
+
+        private:
+            struct Record
+            {
+                std::atomic<sequence_type> sequence; // Written sequence + 1
+                Level level;
+                const char *format;
+                argument_type arguments[MAX_ARGUMENTS];
+            };
+
+            static std::array<Record, CAPACITY> _records;
+            static std::atomic<sequence_type> _next;
+            static std::atomic<int> _level;
+
+            static sequence_type _dumped;
+
+            static void Format(std::ostream &stream, const char *format,
+                               const argument_type *arguments);
+    };
+}
+
+#if SVM_TRACE_LEVEL >= SVM_TRACE_LEVEL_ERROR
+    #define SVM_TRACE_ERROR(...) \
+        ::svm::Trace::Write(::svm::Trace::Error, __VA_ARGS__)
+#else
+    #define SVM_TRACE_ERROR(...) ((void) 0)
+#endif
+
+#if SVM_TRACE_LEVEL >= SVM_TRACE_LEVEL_INFO
+    #define SVM_TRACE_INFO(...) \
+        ::svm::Trace::Write(::svm::Trace::Info, __VA_ARGS__)
+#else
+    #define SVM_TRACE_INFO(...) ((void) 0)
+#endif
+
+#if SVM_TRACE_LEVEL >= SVM_TRACE_LEVEL_DEBUG
+    #define SVM_TRACE_DEBUG(...) \
+        ::svm::Trace::Write(::svm::Trace::Debug, __VA_ARGS__)
+#else
+    #define SVM_TRACE_DEBUG(...) ((void) 0)
+#endif
+
+#endif
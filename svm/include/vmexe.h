@@ -0,0 +1,55 @@
+#ifndef VMEXE_H
+#define VMEXE_H
+
+namespace svm
+{
+    // .vmexe Container
+    //
+    // A file starts with this header followed by its sections. Every field
+    //  is a host-endian `int` like the instructions, sizes and offsets are
+    //  in cells. Sections start at multiples of `alignment` (a power of two,
+    //  a page of the default size), so they can be copied page by page.
+    //
+    //     code:    instructions, loaded into the kernel heap, execution
+    //              starts at `entry_point`
+    //     data:    initial contents of the data address space at
+    //              `data_address`, shared copy-on-write between the
+    //              processes of the image
+    //     bss:     cells after the data that start as zeroes
+    //     decoded: optional, reserved for pre-decoded instructions
+    //              (`HAS_DECODED`), loaders that do not know it skip it
+    //
+    // Files without the magic number are raw images of the code from
+    //  older versions of `svmasm`.
+    struct ExecutableHeader
+    {
+        static const int MAGIC = 0x584D5653; // "SVMX" on little-endian hosts
+        static const int VERSION = 1;
+        static const int DEFAULT_ALIGNMENT = 0x80;
+
+        static const int HAS_DECODED = 0x1;
+
+        int magic;
+        int version;
+        int header_size; // Cells of the header, later versions may grow it
+        int alignment;
+        int flags;
+        int entry_point; // Offset in the code section
+
+        int code_offset;
+        int code_size;
+
+        int data_offset;
+        int data_size;
+        int data_address;
+
+        int bss_size;
+
+        int decoded_offset;
+        int decoded_size;
+
+        int reserved[2];
+    };
+}
+
+#endif
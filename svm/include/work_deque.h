@@ -0,0 +1,84 @@
+#ifndef WORK_DEQUE_H
+#define WORK_DEQUE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "process.h"
+
+namespace svm
+{
+    // Work-Stealing Deque of Processes
+    //
+    // Chase-Lev deque: the owning core pushes and takes processes at the
+    //  bottom without locks, any other core can steal the process at the top
+    //  concurrently. Only a steal and a take of the last process race, they
+    //  are resolved with a CAS on `_top`. The buffer grows on the owner side,
+    //  retired buffers are kept until the deque is destroyed, so a thief
+    //  never reads freed memory.
+    class WorkDeque
+    {
+        public:
+            typedef long long index_type;
+
+            static const index_type INITIAL_CAPACITY = 0x20;
+
+            WorkDeque();
+            virtual ~WorkDeque();
+
+            // Owner side
+            void Push(Process *process);
+            Process *Take(); // The last pushed process or NULL
+
+            // Any core. Returns the first pushed process, NULL if the deque
+            //  is empty or another core got the process first.
+            Process *Steal();
+
+            // Can be out of date as soon as it returns
+            index_type Size() const
+            {
+                index_type size = _bottom.load(std::memory_order_relaxed) -
+                                  _top.load(std::memory_order_relaxed);
+
+                return size > 0 ? size : 0;
+            }
+
+            bool IsEmpty() const
+            {
+                return Size() == 0;
+            }
+
+        private:
+            struct Buffer
+            {
+                index_type mask;
+                std::unique_ptr<std::atomic<Process *>[]> cells;
+
+                Buffer(index_type capacity);
+
+                Process *Get(index_type index) const
+                {
+                    return cells[index & mask].load(std::memory_order_relaxed);
+                }
+
+                void Put(index_type index, Process *process)
+                {
+                    cells[index & mask].store(process, std::memory_order_relaxed);
+                }
+            };
+
+            std::atomic<index_type> _top;
+            std::atomic<index_type> _bottom;
+            std::atomic<Buffer *> _buffer;
+
+            std::vector<std::unique_ptr<Buffer> > _buffers; // Owner side only
+
+            WorkDeque(const WorkDeque &);
+            WorkDeque &operator=(const WorkDeque &);
+
+            Buffer *Grow(Buffer *buffer, index_type top, index_type bottom);
+    };
+}
+
+#endif
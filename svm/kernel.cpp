@@ -2,336 +2,1249 @@
 
 #include <iostream>
 #include <string>
-#include <fstream>
 #include <algorithm>
 #include <limits>
+#include <set>
+#include <thread>
+#include <utility>
+
+#include "trace.h"
 
 namespace svm
 {
+    Kernel::Processor::Processor(unsigned int id, Core &core,
+                                 ProcessHeap::Order order,
+                                 FrameAllocator &frame_allocator)
+    : id(id),
+    core(core),
+    processes(order),
+    backlog(),
+    frames(frame_allocator),
+    resident_pages(),
+    clock_hand(0),
+    is_waiting_for_frame(false),
+    next_boost_time(0),
+    finished_process_count(0),
+    total_turnaround_time(0),
+    total_waiting_time(0),
+    total_page_table_size(0),
+    busy_time(0),
+    steal_count(0),
+    results(),
+    random_state(id * 0x9E3779B9u + 1) { }
+
+    Kernel::Processor::~Processor()
+    {
+        // Left over if the board was stopped early
+        while (Process *process = backlog.Take()) {
+            delete process;
+        }
+    }
+
+    Kernel::Kernel(unsigned int core_count, Memory::ram_size_type ram_size,
+                   Memory::ram_size_type page_size,
+                   SwapSpace::size_type swap_size)
+    : board(core_count, ram_size, page_size, swap_size),
+    processors(),
+    scheduler(Undefined),
+    _last_issued_process_id(0),
+    _quanta(),
+    _admission_window(core_count > 1 ? _ADMISSION_WINDOW :
+                                       std::numeric_limits<RunQueue::size_type>::max()),
+    _replacement(Clock),
+    _working_set_window(DEFAULT_WORKING_SET_WINDOW),
+    _is_board_used(false),
+    _busy_core_count(0),
+    _frame_waiter_count(0),
+    _images(),
+    _image_index(),
+    _shared_image_count(0),
+    _zero_frame(Memory::INVALID_PAGE) { }
+
     Kernel::Kernel(
     Scheduler scheduler,
     //std::vector<Memory::ram_type> executables_paths
-    std::vector<std::string> executables_paths
+    std::vector<std::string> executables_paths,
+    quantum_list_type quanta,
+    unsigned int core_count,
+    Memory::ram_size_type ram_size,
+    Memory::ram_size_type page_size,
+    SwapSpace::size_type swap_size,
+    Replacement replacement,
+    CPU::cycle_count_type working_set_window
     )
-    : board(),
-    processes(),
-    priorities(),
-    scheduler(scheduler),
+    : board(core_count, ram_size, page_size, swap_size),
+    processors(),
+    scheduler(Undefined),
     _last_issued_process_id(0),
-    _last_ram_position(0),
-    _cycles_passed_after_preemption(0),
-    _current_process_index(0)
+    _quanta(),
+    _admission_window(core_count > 1 ? _ADMISSION_WINDOW :
+                                       std::numeric_limits<RunQueue::size_type>::max()),
+    _replacement(Clock),
+    _working_set_window(DEFAULT_WORKING_SET_WINDOW),
+    _is_board_used(false),
+    _busy_core_count(0),
+    _frame_waiter_count(0),
+    _images(),
+    _image_index(),
+    _shared_image_count(0),
+    _zero_frame(Memory::INVALID_PAGE)
+    {
+        Run(scheduler, executables_paths, quanta, replacement, working_set_window);
+
+        Trace::Dump(std::cout);
+
+        Report(std::cout);
+    }
+
+    Kernel::~Kernel() { }
+
+    void Kernel::Run(Scheduler scheduler,
+                     const std::vector<std::string> &executables_paths,
+                     const quantum_list_type &quanta,
+                     Replacement replacement,
+                     CPU::cycle_count_type working_set_window)
     {
+        // The handlers of the previous run refer to its processors
+        processors.clear();
+        if (_is_board_used) {
+            board.Reset();
+        }
+        _is_board_used = true;
+
+        this->scheduler = scheduler;
+        _last_issued_process_id = 0;
+
+        _replacement = replacement;
+        _working_set_window = working_set_window;
+
+        _quanta = quanta;
+        if (_quanta.empty()) {
+            // Four levels with the quantum doubled on every level
+            CPU::cycle_count_type quantum = DEFAULT_QUANTUM;
+            for (int level = scheduler == MultilevelFeedbackQueue ? 4 : 1; level > 0; --level) {
+                _quanta.push_back(quantum);
+                quantum *= 2;
+            }
+        }
+        if (_quanta.size() > RunQueue::LEVEL_COUNT) {
+            _quanta.resize(RunQueue::LEVEL_COUNT);
+        }
+        std::replace(_quanta.begin(), _quanta.end(),
+                     static_cast<CPU::cycle_count_type>(0),
+                     static_cast<CPU::cycle_count_type>(1));
+
         // Memory
-        board.memory.ram[0] = _free_physical_memory_index = 0;
-        board.memory.ram[1] = board.memory.ram.size() - 2;
+        //
+        // Free blocks of the kernel heap (program images) are kept in a list
+        //  ordered by address. Every block starts with the index of the next
+        //  free block and the number of cells after the header. The list
+        //  starts with an empty block at the index 0 that is never
+        //  allocated. The heap starts with the rest of the frame 0, which
+        //  the frame allocator never hands out, and grows by frames.
+        board.memory.ram[0] = 2;
+        board.memory.ram[1] = 0;
+        board.memory.ram[2] = 0;
+        board.memory.ram[3] = board.memory.PageSize() - 4;
+
+        _images.clear();
+        _image_index.clear();
+        _shared_image_count = 0;
+
+        _zero_frame = board.memory.AcquireFrame();
+        if (_zero_frame != Memory::INVALID_PAGE) {
+            std::fill(board.memory.ram.begin() + _zero_frame,
+                      board.memory.ram.begin() + _zero_frame + board.memory.PageSize(), 0);
+        }
+
+        ProcessHeap::Order order =
+            scheduler == ShortestJob || scheduler == ShortestRemainingTime ?
+                ProcessHeap::ShortestBurst : ProcessHeap::HighestPriority;
+        for (Board::core_list_type::size_type i = 0; i < board.cores.size(); ++i) {
+            processors.push_back(std::unique_ptr<Processor>(
+                new Processor(i, *board.cores[i], order, board.memory.frames)));
+            processors.back()->next_boost_time = _BOOST_PERIOD;
+
+            InstallHandlers(*processors.back());
+        }
+
+        //Process Management
+        std::vector<Process *> created;
+        std::for_each(executables_paths.begin(), executables_paths.end(), [&](const std::string &path) {
+            Process *process = CreateProcess(path);
+            if (process != NULL) {
+                created.push_back(process);
+            }
+        });
+
+        // The processes are spread over the cores in turn. They are pushed
+        //  in reverse, so every core takes its own processes in the order
+        //  they were created and others steal the last ones first. A shared
+        //  image is translated once per core.
+        std::set<std::pair<unsigned int, Memory::ram_size_type> > translated;
+        for (std::vector<Process *>::reverse_iterator it = created.rbegin();
+                it != created.rend(); ++it) {
+            Processor &processor = *processors[(*it)->id % processors.size()];
+            (*it)->cpu = processor.id;
+            if (translated.insert(std::make_pair(processor.id, (*it)->memory_start_position)).second) {
+                processor.core.cpu.TranslateImage((*it)->memory_start_position,
+                                                  (*it)->memory_end_position - (*it)->memory_start_position);
+            }
+            processor.backlog.Push(*it);
+        }
+
+        _busy_core_count.store(0);
+        _frame_waiter_count.store(0);
+
+        bool has_processes = false;
+        for (processor_list_type::iterator it = processors.begin();
+                it != processors.end(); ++it) {
+            Processor &processor = **it;
+            Admit(processor);
+            if (processor.processes.IsEmpty()) {
+                // Nothing to run on this core
+                processor.core.online = false;
+
+                continue;
+            }
+            has_processes = true;
+            ++_busy_core_count;
+
+            Dispatch(processor,
+                     scheduler == FirstComeFirstServed || scheduler == RoundRobin ||
+                     scheduler == MultilevelFeedbackQueue ?
+                         processor.processes.NextReady() :
+                         processor.processes.Preferred());
+
+            // The preemptive schedulers only need the timer when a quantum
+            //  ends, the others run without timer interrupts at all
+            if (scheduler == RoundRobin || scheduler == Priority ||
+                    scheduler == ShortestRemainingTime ||
+                    scheduler == MultilevelFeedbackQueue) {
+                ArmQuantum(processor);
+            } else {
+                processor.core.pit.Disarm();
+            }
+        }
+
+        if (has_processes) {
+            board.Start();
+        }
+    }
+
+    Kernel::result_list_type Kernel::Results() const
+    {
+        result_list_type results;
+        for (processor_list_type::const_iterator it = processors.begin();
+                it != processors.end(); ++it) {
+            results.insert(results.end(), (*it)->results.begin(), (*it)->results.end());
+        }
+
+        std::sort(results.begin(), results.end(),
+                  [](const ProcessResult &first, const ProcessResult &second) {
+                      return first.id < second.id;
+                  });
+
+        return results;
+    }
+
+    void Kernel::Report(std::ostream &output) const
+    {
+        Process::process_id_type finished_process_count = 0;
+        CPU::cycle_count_type total_turnaround_time = 0;
+        CPU::cycle_count_type total_waiting_time = 0;
+        PageTable::size_type total_page_table_size = 0;
+        TLB::counter_type tlb_hits = 0;
+        TLB::counter_type tlb_misses = 0;
+        CPU::cycle_count_type elapsed_time = 0;
+        for (processor_list_type::const_iterator it = processors.begin();
+                it != processors.end(); ++it) {
+            elapsed_time = std::max(elapsed_time, (*it)->core.pit.Now());
+        }
+        for (processor_list_type::const_iterator it = processors.begin();
+                it != processors.end(); ++it) {
+            if (processors.size() > 1) {
+                output << "Kernel: CPU " << (*it)->id
+                          << ", finished processes: " << (*it)->finished_process_count
+                          << ", steals: " << (*it)->steal_count
+                          << ", busy cycles: " << (*it)->busy_time
+                          << ", utilization: "
+                          << (elapsed_time > 0 ? 100.0 * (*it)->busy_time / elapsed_time : 0.0)
+                          << "%" << std::endl;
+            }
+
+            finished_process_count += (*it)->finished_process_count;
+            total_turnaround_time += (*it)->total_turnaround_time;
+            total_waiting_time += (*it)->total_waiting_time;
+            total_page_table_size += (*it)->total_page_table_size;
+            tlb_hits += (*it)->core.cpu.tlb.hits;
+            tlb_misses += (*it)->core.cpu.tlb.misses;
+        }
+
+        if (finished_process_count > 0) {
+            output << "Kernel: finished processes: " << finished_process_count
+                      << ", average turnaround time: "
+                      << static_cast<double>(total_turnaround_time) / finished_process_count
+                      << " cycles, average waiting time: "
+                      << static_cast<double>(total_waiting_time) / finished_process_count
+                      << " cycles" << std::endl;
+            output << "Kernel: average page table size: "
+                      << total_page_table_size / finished_process_count
+                      << " bytes" << std::endl;
+        }
+
+        output << "Kernel: TLB hits: " << tlb_hits
+                  << ", misses: " << tlb_misses << std::endl;
+
+        // Paging of the finished processes, the fault rate is per 1000
+        //  cycles of CPU time
+        static const char *const REPLACEMENT_NAMES[] = { "clock", "aging", "working set" };
+
+        Process::counter_type page_fault_count = 0;
+        Process::counter_type swap_in_count = 0;
+        Process::counter_type swap_out_count = 0;
+        result_list_type results = Results();
+        for (result_list_type::const_iterator it = results.begin();
+                it != results.end(); ++it) {
+            if (it->page_fault_count > 0) {
+                output << "Kernel: process " << it->id
+                       << ", page faults: " << it->page_fault_count
+                       << " (" << (it->cpu_time > 0 ? 1000.0 * it->page_fault_count / it->cpu_time : 0.0)
+                       << " per 1000 cycles), copy-on-write: " << it->copy_on_write_count
+                       << ", swap in: " << it->swap_in_count
+                       << ", swap out: " << it->swap_out_count << std::endl;
+            }
+
+            page_fault_count += it->page_fault_count;
+            swap_in_count += it->swap_in_count;
+            swap_out_count += it->swap_out_count;
+        }
+
+        output << "Kernel: replacement: " << REPLACEMENT_NAMES[_replacement]
+               << ", page faults: " << page_fault_count
+               << ", swap in: " << swap_in_count
+               << ", swap out: " << swap_out_count
+               << ", swap slots: " << board.swap.SlotCount()
+               << " (" << board.swap.UsedCount() << " used)" << std::endl;
+
+        output << "Kernel: images: " << _last_issued_process_id - _shared_image_count
+               << " loaded, " << _shared_image_count << " shared" << std::endl;
+
+        // Frames in the caches of the CPUs are free, but taken from the
+        //  shared allocator
+        FrameAllocator::size_type cached_frame_count = 0;
+        for (processor_list_type::const_iterator it = processors.begin();
+                it != processors.end(); ++it) {
+            cached_frame_count += (*it)->frames.Size();
+        }
+        const FrameAllocator &frames = board.memory.frames;
+        output << "Kernel: frames: " << frames.FrameCount()
+               << ", free: " << frames.FreeCount() + cached_frame_count
+               << " (" << cached_frame_count << " cached), used: "
+               << frames.UsedCount() - cached_frame_count << std::endl;
+
+        for (Board::core_list_type::const_iterator it = board.cores.begin();
+                it != board.cores.end(); ++it) {
+            if (!(*it)->cpu.profile.IsEmpty()) {
+                (*it)->cpu.profile.Report(output);
+            }
+        }
+    }
+
+    Process *Kernel::CreateProcess(const std::string &name)
+    {
+        Process *process = NULL;
+
+        if (_last_issued_process_id == std::numeric_limits<Process::process_id_type>::max()) {
+            std::cerr << "Kernel: failed to create a new process. The maximum number of processes has been reached." << std::endl;
+            } else {
+            // The file is mapped once for every kernel that loads it
+            std::shared_ptr<const Executable> executable = Executable::Open(name);
+            // Pages beyond the RAM live in the swap space
+            Memory::vmem_size_type address_space_size =
+                board.memory.ram.size() + board.swap.SlotCount() * board.memory.PageSize();
+            if (executable && executable->DataEnd() > address_space_size) {
+                std::cerr << "Kernel: the data of the program does not fit into the address space." << std::endl;
+            } else if (executable) {
+                Memory::page_table_type *page_table = board.memory.CreateEmptyPageTable(address_space_size);
+                Memory::ram_size_type new_memory_position = LoadImage(executable, *page_table);
+                if (new_memory_position == _INVALID_MEMORY_POSITION) {
+                    std::cerr << "Kernel: failed to allocate memory." << std::endl;
+                    delete page_table;
+                    } else {
+                    process = new Process(_last_issued_process_id++, new_memory_position,
+                    new_memory_position + executable->CodeSize(),
+                    page_table);
+                    process->registers.ip = new_memory_position + executable->EntryPoint();
+                    process->arrival_time = board.pit.Now();
+                }
+            }
+        }
+
+        return process;
+    }
+
+    void Kernel::InstallHandlers(Processor &processor)
+    {
+        Core &core = processor.core;
+        RunQueue &processes = processor.processes;
+
         //Check for empty frame
-        board.pic.isr_4 = [&]() {
-            std::cout << "Kernel: page fault." << std::endl;
+        core.pic.SetISR(PIC::PAGE_FAULT_VECTOR, [this, &processor, &core]() {
+            Memory::page_entry_type page = core.cpu.registers.a;
+            bool write = core.cpu.registers.b != 0;
 
-            Memory::page_entry_type page = board.cpu.registers.a;
-            Memory::page_entry_type frame = board.memory.AcquireFrame();
+            SVM_TRACE_DEBUG("Kernel: page fault on the page {}.", page);
 
-            if(frame != Memory::INVALID_PAGE)
+            if (page >= core.cpu.page_table->PageCount())
             {
-                (*(board.memory.page_table))[page] = frame;
+                SVM_TRACE_ERROR("Kernel: the page {} is outside of the address space. Stopping the board.", page);
 
+                board.Stop();
             }
-            else
+            else if (!PageIn(processor, page, write))
             {
+                SVM_TRACE_ERROR("Kernel: out of frames and swap space for the page {}. Stopping the board.", page);
+
                 board.Stop();
             }
-        };
-        //Process Management
-        std::for_each(executables_paths.begin(), executables_paths.end(), [&](const std::string &path) {
-            CreateProcess(path);
         });
 
-        if (!processes.empty()) {
-            std::cout << "Kernel: set process: " << processes[_current_process_index].id << " for execution." << std::endl;
-
-            board.cpu.registers = processes[_current_process_index].registers;
-            board.memory.page_table = processes[_current_process_index].page_table;
-
-            processes[_current_process_index].state = Process::Running;
-        }
         if (scheduler == FirstComeFirstServed) {
-            board.pic.isr_0 = [&]() {
-                // ToDo: Process the timer interrupt for the FCFS
-            };
+            core.pic.SetISR(PIC::TIMER_VECTOR, []() {
+                // Not preemptive, the timer is disarmed
+            });
 
-            board.pic.isr_3 = [&]() {
-                // ToDo: Process the first software interrupt for the FCFS
+            core.pic.SetISR(PIC::SoftwareInterruptVector(1), [this, &processor, &processes]() {
                 // Unload the current process
-                std::cout << "Number of Processes left = " << processes.size() << std::endl;
-                processes.pop_front();
-                if (processes.empty()) {
-                    board.Stop();
-                }
-                else {
-                    board.cpu.registers = processes[0].registers;
-                    processes[0].state = Process::States::Running;
-                }
-            };
+                Exit(processor);
+                Dispatch(processor, processes.NextReady());
+            });
             } else if (scheduler == ShortestJob) {
-            board.pic.isr_0 = [&]() {
-                // ToDo: Process the timer interrupt for the Shortest
-                //  Job scheduler
-            };
-
-            board.pic.isr_3 = [&]() {
-                // ToDo: Process the first software interrupt for the Shortest
-                //  Job scheduler
-                // Unload the current process
-                std::cout << "Number of Processes left = " << processes.size() << std::endl;
+            core.pic.SetISR(PIC::TIMER_VECTOR, []() {
+                // Not preemptive, the timer is disarmed
+            });
 
-                processes.pop_front();
+            core.pic.SetISR(PIC::SoftwareInterruptVector(1), [this, &processor, &processes]() {
+                // Unload the current process, the ready process with the
+                //  shortest predicted burst runs next
+                Exit(processor);
+                Dispatch(processor, processes.Preferred());
+            });
+            } else if (scheduler == ShortestRemainingTime) {
+            core.pic.SetISR(PIC::TIMER_VECTOR, [this, &processor, &processes, &core]() {
+                // Preempt the current process if a ready one is predicted to
+                //  finish its burst before the rest of the current burst
+                Process *process = processes.Running();
+                Process *shortest = processes.Preferred();
+                if (process != NULL && shortest != NULL) {
+                    CPU::cycle_count_type elapsed = core.pit.Now() - process->burst_start_time;
+                    CPU::cycle_count_type remaining =
+                        process->predicted_burst > elapsed ? process->predicted_burst - elapsed : 0;
 
-                if (processes.empty()) {
-                    board.Stop();
-                }
-                else {
-                    board.cpu.registers = processes[0].registers;
-                    processes[0].state = Process::States::Running;
+                    if (shortest->predicted_burst < remaining) {
+                        Preempt(processor);
+                        Dispatch(processor, processes.Preferred());
+                    }
                 }
-            };
-            } else if (scheduler == RoundRobin) {
-            board.pic.isr_0 = [&]() {
-                std::cout << "Kernel: processing the timer interrupt." << std::endl;
 
-                if (!processes.empty()) {
-                    if (_cycles_passed_after_preemption <= Kernel::_MAX_CYCLES_BEFORE_PREEMPTION)
-                    {
-                        std::cout << "Kernel: allowing the current process " << processes[_current_process_index].id << " to run." << std::endl;
+                ArmQuantum(processor);
+            });
 
-                        ++_cycles_passed_after_preemption;
+            core.pic.SetISR(PIC::SoftwareInterruptVector(1), [this, &processor, &processes]() {
+                Exit(processor);
+                Dispatch(processor, processes.Preferred());
 
-                        std::cout << "Kernel: the current cycle is " << _cycles_passed_after_preemption << std::endl;
-                        } else {
-                        if (processes.size() > 1) {
-                            std::cout << "Kernel: switching the context from process " << processes[_current_process_index].id;
+                ArmQuantum(processor);
+            });
+            } else if (scheduler == MultilevelFeedbackQueue) {
+            core.pic.SetISR(PIC::TIMER_VECTOR, [this, &processor, &processes]() {
+                // The running process used up its quantum and is demoted
+                Process *process = processes.Running();
+                if (process != NULL) {
+                    if (process->level + 1 < _quanta.size()) {
+                        processes.SetLevel(*process, process->level + 1);
+                    }
+                    Preempt(processor);
+                }
 
-                            processes[_current_process_index].registers = board.cpu.registers;
-                            processes[_current_process_index].state = Process::Ready;
+                BoostIfDue(processor);
+                Dispatch(processor, processes.NextReady());
 
-                            _current_process_index = (_current_process_index + 1) % processes.size();
+                ArmQuantum(processor);
+            });
 
-                            std::cout << " to process " << processes[_current_process_index].id << std::endl;
+            core.pic.SetISR(PIC::SoftwareInterruptVector(1), [this, &processor, &processes]() {
+                Exit(processor);
 
-                            board.cpu.registers = processes[_current_process_index].registers;
-                            board.memory.page_table = processes[_current_process_index].page_table;
+                BoostIfDue(processor);
+                Dispatch(processor, processes.NextReady());
 
-                            processes[_current_process_index].state = Process::Running;
-                        }
+                ArmQuantum(processor);
+            });
 
-                        _cycles_passed_after_preemption = 0;
+            core.pic.SetISR(PIC::SoftwareInterruptVector(2), [this, &processor, &processes]() {
+                // Yield: the running process gave up the CPU before its
+                //  quantum ended and is promoted
+                Process *process = processes.Running();
+                if (process != NULL) {
+                    if (process->level > 0) {
+                        processes.SetLevel(*process, process->level - 1);
                     }
+                    Preempt(processor);
                 }
 
-                std::cout << std::endl;
-            };
-            board.pic.isr_3 = [&]() {
-                std::cout << "Kernel: processing the first software interrupt." << std::endl;
+                BoostIfDue(processor);
+                Dispatch(processor, processes.NextReady());
 
-                if (!processes.empty()) {
-                    std::cout << "Kernel: unloading the process " << processes[_current_process_index].id << std::endl;
-                    FreeMemory(processes[_current_process_index].memory_start_position);
-                    processes.erase(processes.begin() + _current_process_index);
-
-                    if (processes.empty()) {
-                        _current_process_index = 0;
+                ArmQuantum(processor);
+            });
+            } else if (scheduler == RoundRobin) {
+            core.pic.SetISR(PIC::TIMER_VECTOR, [this, &processor, &processes]() {
+                // The one-shot deadline is only reached when the quantum of
+                //  the current process is used up
+                if (processes.ReadyCount() > 0) {
+                    Preempt(processor);
+                    Dispatch(processor, processes.NextReady());
+                }
 
-                        std::cout << "Kernel: no more processes. Stopping the board." << std::endl;
+                ArmQuantum(processor);
+            });
+            core.pic.SetISR(PIC::SoftwareInterruptVector(1), [this, &processor, &processes]() {
+                Exit(processor);
+                Dispatch(processor, processes.NextReady());
 
-                        board.Stop();
-                        } else {
-                        if (_current_process_index >= processes.size()) {
-                            _current_process_index %= processes.size();
-                        }
+                ArmQuantum(processor);
+            });
+            } else if (scheduler == Priority) {
+            core.pic.SetISR(PIC::TIMER_VECTOR, [this, &processor, &processes]() {
+                // The one-shot deadline is only reached when the quantum of
+                //  the current process is used up
+                ArmQuantum(processor);
 
-                        std::cout << "Kernel: switching the context to process " << processes[_current_process_index].id << std::endl;
+                Process *process = processes.Running();
+                if (process != NULL) {
+                    if (process->priority > 0) {
+                        processes.SetPriority(*process, process->priority - 1);
+                    }
+                    Preempt(processor);
 
-                        board.cpu.registers = processes[_current_process_index].registers;
-                        board.memory.page_table = processes[_current_process_index].page_table;
+                    process = processes.Preferred();
+                    if (process->priority < std::numeric_limits<Process::process_priority_type>::max()) {
+                        processes.SetPriority(*process, process->priority + 1);
+                    }
+                    Dispatch(processor, process);
+                }
+            });
 
-                        processes[_current_process_index].state = Process::Running;
+            core.pic.SetISR(PIC::SoftwareInterruptVector(1), [this, &processor, &processes, &core]() {
+                if (core.cpu.registers.a == 1) {
+                    // Unload the current process
+                    Exit(processor);
+                    Dispatch(processor, processes.Preferred());
 
-                        _cycles_passed_after_preemption = 0;
+                    ArmQuantum(processor);
+                    } else if (core.cpu.registers.a == 2) {
+                    Process *process = processes.Running();
+                    if (process != NULL) {
+                        processes.SetPriority(*process, core.cpu.registers.b);
+                        process->updateCycles();
                     }
                 }
+            });
+        }
+    }
 
-                std::cout << std::endl;
-            };
-            } else if (scheduler == Priority) {
-            board.pic.isr_0 = [&]() {
-                // ToDo: Process the timer interrupt for the Priority Queue
-                //  scheduler
-                ++_cycles_passed_after_preemption;
-                if (_cycles_passed_after_preemption > _MAX_CYCLES_BEFORE_PREEMPTION) {
-                    _cycles_passed_after_preemption = 0;
+    Memory::ram_size_type Kernel::AllocateMemory(Memory::ram_size_type units)
+    {
+        std::lock_guard<std::mutex> lock(_memory_mutex);
 
-                    Process oldProcess = priorities.top();
-                    priorities.pop();
+        Memory::ram_type &ram = board.memory.ram;
 
-                    oldProcess.state = Process::States::Ready;
-                    --oldProcess.priority;
+        for (;;) {
+            Memory::ram_size_type position = AllocateFreeBlock(units);
+            if (position != _INVALID_MEMORY_POSITION) {
+                return position;
+            }
 
-                    priorities.push(oldProcess);
+            // The heap grows by whole frames taken from the frame
+            //  allocator, so images never share a frame with a page
+            Memory::ram_size_type page_size = board.memory.PageSize();
+            Memory::ram_size_type frame_count = (units + 2 + page_size - 1) / page_size;
+            Memory::ram_size_type block = board.memory.frames.AcquireContiguous(frame_count);
+            if (block == FrameAllocator::INVALID_FRAME) {
+                return _INVALID_MEMORY_POSITION;
+            }
 
-                    Process newProcess = priorities.top();
-                    priorities.pop();
+            ram[block + 1] = frame_count * page_size - 2;
+            LinkFreeBlock(block);
+        }
+    }
 
-                    board.cpu.registers = newProcess.registers;
-                    newProcess.state = Process::States::Running;
-                    ++newProcess.priority;
+    Memory::ram_size_type Kernel::AllocateFreeBlock(Memory::ram_size_type units)
+    {
+        Memory::ram_type &ram = board.memory.ram;
 
-                    priorities.push(newProcess);
-                }
-            };
+        // First fit, the block is cut from the start of the free one
+        for (Memory::ram_size_type previous = 0, block = ram[0]; block != 0;
+                previous = block, block = ram[block]) {
+            Memory::ram_size_type size = ram[block + 1];
+            if (size > units + 2) {
+                Memory::ram_size_type rest = block + 2 + units;
+                ram[rest] = ram[block];
+                ram[rest + 1] = size - units - 2;
+                ram[previous] = rest;
 
-            board.pic.isr_3 = [&]() {
-                // ToDo: Process the first software interrupt for the Priority
-                //  Queue scheduler
-                // Unload the current process
-                std::cout << "Number of Processes left = " << processes.size() << std::endl;
-                if (board.cpu.registers.a == 1) {
-                    priorities.pop();
-                    if (priorities.empty()) {
-                        board.Stop();
-                    }
-                    else {
-                        Process t = priorities.top();
-                        board.cpu.registers = t.registers;
-                        priorities.pop();
-                        t.state = Process::States::Running;
-                        priorities.push(t);
-                    }
-                    } else if (board.cpu.registers.a == 2) {
-                    Process t = priorities.top();
-                    priorities.pop();
-                    t.priority = board.cpu.registers.b;
-                    t.updateCycles();
-                    priorities.push(t);
-                }
-            };
+                ram[block + 1] = units;
+
+                return block + 2;
+            } else if (size >= units) {
+                ram[previous] = ram[block];
+
+                return block + 2;
+            }
         }
 
-        // ToDo
+        return _INVALID_MEMORY_POSITION;
+    }
 
-        // ---
+    void Kernel::FreeMemory(Memory::ram_size_type physical_memory_index)
+    {
+        std::lock_guard<std::mutex> lock(_memory_mutex);
 
-        board.Start();
+        LinkFreeBlock(physical_memory_index - 2);
+        ReleaseFreeFrames();
     }
 
-    Kernel::~Kernel() { }
+    void Kernel::LinkFreeBlock(Memory::ram_size_type block)
+    {
+        Memory::ram_type &ram = board.memory.ram;
+
+        Memory::ram_size_type size = ram[block + 1];
+
+        Memory::ram_size_type previous = 0;
+        while (ram[previous] != 0 && static_cast<Memory::ram_size_type>(ram[previous]) < block) {
+            previous = ram[previous];
+        }
+
+        // Merge with the free neighbours
+        Memory::ram_size_type next = ram[previous];
+        if (next != 0 && block + 2 + size == next) {
+            size += 2 + ram[next + 1];
+            next = ram[next];
+        }
+
+        if (previous != 0 && previous + 2 + ram[previous + 1] == block) {
+            ram[previous + 1] += 2 + size;
+            ram[previous] = next;
+        } else {
+            ram[block] = next;
+            ram[block + 1] = size;
+            ram[previous] = block;
+        }
+    }
 
-    void Kernel::CreateProcess(const std::string &name)
+    void Kernel::ReleaseFreeFrames()
     {
-        if (_last_issued_process_id == std::numeric_limits<Process::process_id_type>::max()) {
-            std::cerr << "Kernel: failed to create a new process. The maximum number of processes has been reached." << std::endl;
+        Memory::ram_type &ram = board.memory.ram;
+        Memory::ram_size_type page_size = board.memory.PageSize();
+
+        Memory::ram_size_type previous = 0;
+        while (ram[previous] != 0) {
+            Memory::ram_size_type block = ram[previous];
+            Memory::ram_size_type next = ram[block];
+            Memory::ram_size_type end = block + 2 + ram[block + 1];
+
+            // The parts of the block before and after the whole frames stay
+            //  free blocks, so they need room for a header
+            Memory::ram_size_type first = (block + page_size - 1) / page_size * page_size;
+            if (first - block == 1) {
+                first += page_size;
+            }
+            Memory::ram_size_type last = end / page_size * page_size;
+            if (end - last == 1) {
+                last = last >= page_size ? last - page_size : 0;
+            }
+            if (first >= last) {
+                previous = block;
+
+                continue;
+            }
+
+            for (Memory::ram_size_type frame = first; frame < last; frame += page_size) {
+                board.memory.ReleaseFrame(frame);
+            }
+
+            Memory::ram_size_type rest = next;
+            if (end > last) {
+                ram[last] = next;
+                ram[last + 1] = end - last - 2;
+                rest = last;
+            }
+            if (first > block) {
+                ram[block] = rest;
+                ram[block + 1] = first - block - 2;
+                previous = block;
             } else {
-            std::ifstream input_stream(name, std::ios::in | std::ios::binary);
-            if (!input_stream) {
-                std::cerr << "Kernel: failed to open the program file." << std::endl;
-                } else {
-                Memory::ram_type ops;
-                input_stream.seekg(0, std::ios::end);
-                auto file_size = input_stream.tellg();
-                input_stream.seekg(0, std::ios::beg);
-                ops.resize(static_cast<Memory::ram_size_type>(file_size) / 4);
-                input_stream.read(reinterpret_cast<char *>(&ops[0]), file_size);
-
-                if (input_stream.bad()) {
-                    std::cerr << "Kernel: failed to read the program file." << std::endl;
-                    } else {
-                    Memory::ram_size_type new_memory_position = AllocateMemory(ops.size()); // TODO: allocate memory for the process (AllocateMemory)
-                    if (new_memory_position == -1) {
-                        std::cerr << "Kernel: failed to allocate memory." << std::endl;
-                        } else {
-                        std::copy(ops.begin(), ops.end(), (board.memory.ram.begin() + new_memory_position));
-                        Process process(_last_issued_process_id++, new_memory_position,
-                        new_memory_position + ops.size());
-                    }
+                ram[previous] = rest;
+            }
+        }
+    }
+
+    void Kernel::Preempt(Processor &processor)
+    {
+        Process *process = processor.processes.Running();
+        if (process != NULL) {
+            process->registers = processor.core.cpu.registers;
+            processor.busy_time += processor.core.pit.Now() - process->burst_start_time;
+            process->EndBurst(processor.core.pit.Now());
+            processor.processes.SetState(*process, Process::Ready);
+        }
+    }
+
+    void Kernel::Dispatch(Processor &processor, Process *process)
+    {
+        if (process == NULL) {
+            SVM_TRACE_INFO("Kernel: no more processes on the core {}. Stopping the core.", processor.id);
+
+            processor.core.Stop();
+
+            // The frames go back before the core stops being counted, so a
+            //  waiting core that sees the count drop also sees the frames
+            processor.frames.Drain();
+            if (processor.is_waiting_for_frame) {
+                processor.is_waiting_for_frame = false;
+                --_frame_waiter_count;
+            }
+            --_busy_core_count;
+        } else {
+            SVM_TRACE_DEBUG("Kernel: switching the context of the core {} to process {}", processor.id, process->id);
+
+            processor.core.cpu.registers = process->registers;
+            processor.core.cpu.SwitchAddressSpace(process->page_table, process->id);
+
+            process->burst_start_time = processor.core.pit.Now();
+            processor.processes.SetState(*process, Process::Running);
+
+            if (_frame_waiter_count.load(std::memory_order_relaxed) > 0) {
+                processor.frames.Drain();
+            }
+        }
+    }
+
+    void Kernel::Exit(Processor &processor)
+    {
+        RunQueue &processes = processor.processes;
+        CPU::cycle_count_type now = processor.core.pit.Now();
+
+        Process *process = processes.Running();
+        if (process != NULL) {
+            SVM_TRACE_INFO("Kernel: unloading the process {}, {} processes left on the core {}",
+                           process->id, processes.Size() - 1, processor.id);
+
+            processor.busy_time += now - process->burst_start_time;
+            process->EndBurst(now);
+
+            CPU::cycle_count_type turnaround_time = now - process->arrival_time;
+            ++processor.finished_process_count;
+            processor.total_turnaround_time += turnaround_time;
+            processor.total_waiting_time += turnaround_time - process->cpu_time;
+
+            ProcessResult result;
+            result.id = process->id;
+            result.registers = processor.core.cpu.registers;
+            result.turnaround_time = turnaround_time;
+            result.waiting_time = turnaround_time - process->cpu_time;
+            result.cpu_time = process->cpu_time;
+            result.page_fault_count = process->page_fault_count;
+            result.swap_in_count = process->swap_in_count;
+            result.swap_out_count = process->swap_out_count;
+            result.copy_on_write_count = process->copy_on_write_count;
+            processor.results.push_back(result);
+
+            processor.total_page_table_size += process->page_table->MemoryUsage();
+            ReleasePages(processor, *process);
+
+            ReleaseImage(process->memory_start_position);
+
+            processes.Terminate(*process);
+
+            Admit(processor);
+        }
+    }
+
+    Memory::ram_size_type Kernel::LoadImage(const std::shared_ptr<const Executable> &executable,
+                                            Memory::page_table_type &page_table)
+    {
+        std::lock_guard<std::mutex> lock(_image_mutex);
+
+        // Another file may have the same contents
+        std::pair<image_index_type::const_iterator, image_index_type::const_iterator> candidates =
+            _image_index.equal_range(executable->Hash());
+        for (image_index_type::const_iterator it = candidates.first; it != candidates.second; ++it) {
+            SharedImage &shared = _images[it->second];
+            if (shared.executable->HasSameImage(*executable)) {
+                ++shared.reference_count;
+                ++_shared_image_count;
+                MapData(shared, page_table);
+
+                return it->second;
+            }
+        }
+
+        Memory &memory = board.memory;
+        Memory::ram_type &ram = memory.ram;
+        const int *cells = executable->Code();
+        Executable::size_type size = executable->CodeSize();
+
+        // The data is copied into frames page by page, the first and the
+        //  last page are partly zeroes (or bss)
+        SharedImage shared;
+        shared.executable = executable;
+        shared.reference_count = 1;
+        shared.first_data_page = memory.PageOffsetForVirtual(executable->DataAddress()).first;
+        if (executable->DataSize() > 0) {
+            Memory::vmem_size_type data_start = executable->DataAddress();
+            Memory::vmem_size_type data_end = data_start + executable->DataSize();
+            Memory::page_table_size_type last_data_page = memory.PageOffsetForVirtual(data_end - 1).first;
+            for (Memory::page_table_size_type page = shared.first_data_page; page <= last_data_page; ++page) {
+                Memory::page_entry_type frame = memory.AcquireFrame();
+                if (frame == Memory::INVALID_PAGE) {
+                    ReleaseFrames(shared);
+
+                    return _INVALID_MEMORY_POSITION;
                 }
+                shared.data_frames.push_back(frame);
+
+                Memory::vmem_size_type page_start = static_cast<Memory::vmem_size_type>(page) * memory.PageSize();
+                Memory::vmem_size_type first = std::max(page_start, data_start);
+                Memory::vmem_size_type last = std::min(page_start + memory.PageSize(), data_end);
+                std::fill(ram.begin() + frame, ram.begin() + frame + memory.PageSize(), 0);
+                std::copy(executable->Data() + (first - data_start),
+                          executable->Data() + (last - data_start),
+                          ram.begin() + frame + (first - page_start));
             }
         }
+
+        Memory::ram_size_type address = AllocateMemory(size);
+        if (address == _INVALID_MEMORY_POSITION) {
+            ReleaseFrames(shared);
+
+            return _INVALID_MEMORY_POSITION;
+        }
+
+        std::copy(cells, cells + size, ram.begin() + address);
+        for (Board::core_list_type::iterator it = board.cores.begin();
+                it != board.cores.end(); ++it) {
+            (*it)->cpu.InvalidateDecodedInstructions(address, size);
+        }
+
+        MapData(shared, page_table);
+        _images[address] = shared;
+        _image_index.insert(std::make_pair(executable->Hash(), address));
+
+        return address;
     }
 
-        Memory::vmem_size_type Kernel::VirtualMemoryToPhysical(Memory::ram_size_type previous_index){
-        Memory::page_index_offset_pair_type page_index_offset = board.memory.GetPageIndexAndOffsetForVirtualAddress(previous_index);
-        Memory::page_entry_type page = board.memory.page_table->at(page_index_offset.first);
-        Memory::page_entry_type frame = board.memory.AcquireFrame();
+    void Kernel::MapData(const SharedImage &image, Memory::page_table_type &page_table)
+    {
+        for (std::vector<Memory::page_entry_type>::size_type i = 0; i < image.data_frames.size(); ++i) {
+            page_table.Map(image.first_data_page + i, image.data_frames[i] | PageTable::COPY_ON_WRITE);
+        }
+    }
 
-        if (page == Memory::INVALID_PAGE){
-            processes[_current_process_index].page_table->at(previous_index) = frame;
-            return frame + page_index_offset.second;
+    void Kernel::ReleaseFrames(SharedImage &image)
+    {
+        for (std::vector<Memory::page_entry_type>::const_iterator it = image.data_frames.begin();
+                it != image.data_frames.end(); ++it) {
+            board.memory.ReleaseFrame(*it);
         }
-        else
-        {
-            board.Stop();
+        image.data_frames.clear();
+    }
+
+    void Kernel::ReleaseImage(Memory::ram_size_type address)
+    {
+        std::lock_guard<std::mutex> lock(_image_mutex);
+
+        image_map_type::iterator image = _images.find(address);
+        if (image == _images.end() || --image->second.reference_count > 0) {
+            return;
+        }
+
+        std::pair<image_index_type::iterator, image_index_type::iterator> candidates =
+            _image_index.equal_range(image->second.executable->Hash());
+        for (image_index_type::iterator it = candidates.first; it != candidates.second; ++it) {
+            if (it->second == address) {
+                _image_index.erase(it);
+                break;
+            }
         }
+        ReleaseFrames(image->second);
+        _images.erase(image);
+
+        FreeMemory(address);
     }
 
-    Memory::ram_size_type Kernel::AllocateMemory(Memory::ram_size_type units)
+    bool Kernel::PageIn(Processor &processor, Memory::page_table_size_type page,
+                        bool write)
     {
-        Memory::ram_size_type prev_index = _free_physical_memory_index;
-        Memory::ram_size_type current_index;
+        Process &process = *processor.processes.Running();
+        Memory &memory = board.memory;
+
+        ++process.page_fault_count;
+
+        PageTable::entry_type entry = process.page_table->Lookup(page);
+        Process::swap_map_type::const_iterator slot = process.swap_slots.find(page);
+        if (!write && entry == PageTable::INVALID_ENTRY &&
+                slot == process.swap_slots.end() &&
+                _zero_frame != Memory::INVALID_PAGE) {
+            process.page_table->Map(page, _zero_frame | PageTable::COPY_ON_WRITE);
+
+            return true;
+        }
+
+        Processor::ResidentPage resident;
+        resident.process = &process;
+        resident.page = page;
+        resident.age = 0;
+        resident.last_use = VirtualTime(processor, process);
+
+        Memory::page_entry_type frame = processor.frames.Acquire();
+        if (frame == Memory::INVALID_PAGE && processor.resident_pages.empty()) {
+            // Nothing of this core to evict, the other cores hold every
+            //  frame. They return their cached frames while a core waits and
+            //  release the rest as their processes exit.
+            if (!processor.is_waiting_for_frame) {
+                processor.is_waiting_for_frame = true;
+                ++_frame_waiter_count;
+            }
+
+            // The busy cores are counted first, the count only drops and a
+            //  waiting core is busy. Equal counts mean that every busy core
+            //  waited at once, unless a frame shows up for the retry.
+            unsigned int busy_core_count = _busy_core_count.load();
+            bool is_stuck = _frame_waiter_count.load() == busy_core_count;
+
+            frame = processor.frames.Acquire();
+            if (frame == Memory::INVALID_PAGE) {
+                if (is_stuck) {
+                    return false;
+                }
+
+                // The instruction faults again after the handler returns
+                --process.page_fault_count;
+                std::this_thread::yield();
+
+                return true;
+            }
+        }
+        if (processor.is_waiting_for_frame) {
+            processor.is_waiting_for_frame = false;
+            --_frame_waiter_count;
+        }
 
-        for(Memory::ram_size_type next_free_index = board.memory.ram[VirtualMemoryToPhysical(prev_index)]; ;  prev_index = next_free_index, next_free_index = board.memory.ram[next_free_index])
+        if (frame != Memory::INVALID_PAGE) {
+            processor.resident_pages.push_back(resident);
+        } else {
+            frame = Evict(processor);
+            if (frame == Memory::INVALID_PAGE) {
+                return false;
+            }
+
+            processor.resident_pages[processor.clock_hand] = resident;
+            processor.clock_hand = (processor.clock_hand + 1) % processor.resident_pages.size();
+        }
+
+        if ((entry & PageTable::COPY_ON_WRITE) != 0) {
+            SVM_TRACE_DEBUG("Kernel: copying the shared page {} of the process {}.", page, process.id);
+
+            Memory::ram_size_type shared = PageTable::FrameOf(entry);
+            std::copy(memory.ram.begin() + shared,
+                      memory.ram.begin() + shared + memory.PageSize(),
+                      memory.ram.begin() + frame);
+            processor.core.cpu.tlb.Invalidate(process.id, page);
+            ++process.copy_on_write_count;
+        } else if (slot != process.swap_slots.end()) {
+            SVM_TRACE_DEBUG("Kernel: reading the page {} of the process {} from the swap space.", page, process.id);
+
+            board.swap.Read(slot->second, &memory.ram[frame]);
+            ++process.swap_in_count;
+        } else {
+            std::fill(memory.ram.begin() + frame,
+                      memory.ram.begin() + frame + memory.PageSize(), 0);
+        }
+
+        process.page_table->Map(page, frame);
+
+        return true;
+    }
+
+    Memory::page_entry_type Kernel::Evict(Processor &processor)
+    {
+        if (processor.resident_pages.empty()) {
+            return Memory::INVALID_PAGE;
+        }
+
+        SelectVictim(processor);
+
+        const Processor::ResidentPage &victim = processor.resident_pages[processor.clock_hand];
+        Process &owner = *victim.process;
+        PageTable::entry_type entry = owner.page_table->Lookup(victim.page);
+        Memory::page_entry_type frame = PageTable::FrameOf(entry);
+
+        // A clean page is either in the swap space already or was never
+        //  written, so it is filled with zeroes again
+        if ((entry & PageTable::DIRTY) != 0) {
+            Process::swap_map_type::iterator slot = owner.swap_slots.find(victim.page);
+            if (slot == owner.swap_slots.end()) {
+                SwapSpace::slot_type new_slot = board.swap.Acquire();
+                if (new_slot == SwapSpace::INVALID_SLOT) {
+                    return Memory::INVALID_PAGE;
+                }
+                slot = owner.swap_slots.insert(std::make_pair(victim.page, new_slot)).first;
+            }
+
+            SVM_TRACE_DEBUG("Kernel: writing the page {} of the process {} to the swap space.", victim.page, owner.id);
+
+            board.swap.Write(slot->second, &board.memory.ram[frame]);
+            ++owner.swap_out_count;
+        }
+
+        owner.page_table->Map(victim.page, PageTable::INVALID_ENTRY);
+        processor.core.cpu.tlb.Invalidate(owner.id, victim.page);
+
+        return frame;
+    }
+
+    void Kernel::SelectVictim(Processor &processor)
+    {
+        Processor::resident_list_type &pages = processor.resident_pages;
+        Processor::resident_list_type::size_type count = pages.size();
+        Processor::resident_list_type::size_type &hand = processor.clock_hand;
+        TLB &tlb = processor.core.cpu.tlb;
+
+        // Clears the reference bit of the page and returns it. The TLB entry
+        //  goes too, so the next access sets the bit again.
+        auto test_and_clear = [&tlb](const Processor::ResidentPage &resident) {
+            PageTable::entry_type *entry = resident.process->page_table->Find(resident.page);
+            if ((*entry & PageTable::REFERENCED) == 0) {
+                return false;
+            }
+
+            *entry &= ~PageTable::REFERENCED;
+            tlb.Invalidate(resident.process->id, resident.page);
+
+            return true;
+        };
+
+        switch (_replacement)
         {
-            Memory::ram_size_type size = board.memory.ram[VirtualMemoryToPhysical(next_free_index+1)];
-            if( size >= units)
-            {
-                if(size == units)
-                {
-                    board.memory.ram[VirtualMemoryToPhysical(prev_index)] = board.memory.ram[VirtualMemoryToPhysical(next_free_index)];
+            case Clock:
+                // Every page is skipped at most once
+                while (test_and_clear(pages[hand])) {
+                    hand = (hand + 1) % count;
                 }
-                else
-                {
-                    board.memory.ram[VirtualMemoryToPhysical(next_free_index + 1)] -= units + 2;
-                    next_free_index +=  board.memory.ram[VirtualMemoryToPhysical(next_free_index + 1)];
-                    board.memory.ram[VirtualMemoryToPhysical(next_free_index + 1)] = units;
+                break;
+
+            case Aging:
+            {
+                Processor::resident_list_type::size_type victim = hand;
+                for (Processor::resident_list_type::size_type i = 0; i < count; ++i) {
+                    Processor::ResidentPage &resident = pages[(hand + i) % count];
+                    resident.age = static_cast<unsigned char>(
+                                       (resident.age >> 1) | (test_and_clear(resident) ? 0x80 : 0));
+                    if (resident.age < pages[victim].age) {
+                        victim = (hand + i) % count;
+                    }
                 }
-                _free_physical_memory_index = prev_index;
-                return next_free_index + 2;
+                hand = victim;
+                break;
             }
-            if(next_free_index == _free_physical_memory_index)
+
+            case WorkingSet:
             {
-                return NULL;
+                Processor::resident_list_type::size_type oldest = hand;
+                CPU::cycle_count_type oldest_idle_time = 0;
+                bool has_oldest = false;
+                for (Processor::resident_list_type::size_type i = 0; i < count; ++i) {
+                    Processor::ResidentPage &resident = pages[(hand + i) % count];
+                    CPU::cycle_count_type now = VirtualTime(processor, *resident.process);
+                    if (test_and_clear(resident)) {
+                        resident.last_use = now;
+
+                        continue;
+                    }
+
+                    CPU::cycle_count_type idle_time = now - resident.last_use;
+                    if (idle_time > _working_set_window) {
+                        hand = (hand + i) % count;
+
+                        return;
+                    }
+                    if (!has_oldest || idle_time > oldest_idle_time) {
+                        oldest = (hand + i) % count;
+                        oldest_idle_time = idle_time;
+                        has_oldest = true;
+                    }
+                }
+                hand = oldest;
+                break;
             }
         }
-        return -1;
     }
 
-    void Kernel::FreeMemory(Memory::ram_size_type physical_memory_index)
+    void Kernel::ReleasePages(Processor &processor, Process &process)
+    {
+        FrameCache &frames = processor.frames;
+        process.page_table->ForEachMapped(
+            [&frames](Memory::page_table_size_type, PageTable::entry_type entry) {
+                if ((entry & PageTable::COPY_ON_WRITE) == 0) {
+                    frames.Release(PageTable::FrameOf(entry));
+                }
+            });
+        processor.core.cpu.tlb.Flush(process.id);
+
+        // Other cores may be waiting for frames to page in
+        if (board.memory.frames.FreeCount() < FrameCache::BATCH ||
+                _frame_waiter_count.load(std::memory_order_relaxed) > 0) {
+            frames.Drain();
+        }
+
+        for (Process::swap_map_type::const_iterator it = process.swap_slots.begin();
+                it != process.swap_slots.end(); ++it) {
+            board.swap.Release(it->second);
+        }
+        process.swap_slots.clear();
+
+        Processor::resident_list_type &pages = processor.resident_pages;
+        pages.erase(std::remove_if(pages.begin(), pages.end(),
+                                   [&process](const Processor::ResidentPage &resident) {
+                                       return resident.process == &process;
+                                   }),
+                    pages.end());
+        if (processor.clock_hand >= pages.size()) {
+            processor.clock_hand = 0;
+        }
+    }
+
+    CPU::cycle_count_type Kernel::VirtualTime(const Processor &processor,
+                                              const Process &process) const
+    {
+        CPU::cycle_count_type time = process.cpu_time;
+        if (process.state == Process::Running) {
+            time += processor.core.pit.Now() - process.burst_start_time;
+        }
+
+        return time;
+    }
+
+    void Kernel::Admit(Processor &processor)
     {
-        Memory::ram_size_type previous_free_block_index = _free_physical_memory_index;
-        Memory::ram_size_type current_block_index = physical_memory_index - 2;
-        for(; !(current_block_index > previous_free_block_index && current_block_index < board.memory.ram[VirtualMemoryToPhysical(previous_free_block_index)]);
-        previous_free_block_index =  board.memory.ram[VirtualMemoryToPhysical(previous_free_block_index)])    {
-            if( previous_free_block_index >= board.memory.ram[VirtualMemoryToPhysical(previous_free_block_index)] &&
-            ((current_block_index > previous_free_block_index || current_block_index < board.memory.ram[VirtualMemoryToPhysical(previous_free_block_index)]))){
+        RunQueue &processes = processor.processes;
+
+        // Own processes first, in the order they were created
+        while (processes.Size() < _admission_window) {
+            Process *process = processor.backlog.Take();
+            if (process == NULL) {
                 break;
             }
+
+            processes.Add(process);
         }
-        if(current_block_index + board.memory.ram[VirtualMemoryToPhysical(current_block_index + 1)] == board.memory.ram[VirtualMemoryToPhysical(previous_free_block_index)])
-        {
-            board.memory.ram[VirtualMemoryToPhysical(current_block_index)] == board.memory.ram[board.memory.ram[VirtualMemoryToPhysical(previous_free_block_index)]];
-            board.memory.ram[VirtualMemoryToPhysical(current_block_index + 1)] +=  board.memory.ram[board.memory.ram[VirtualMemoryToPhysical(previous_free_block_index + 1)]];
+
+        if (processes.IsEmpty()) {
+            Process *process = Steal(processor);
+            if (process != NULL) {
+                Migrate(processor, *process);
+                processes.Add(process);
+            }
         }
-        else
-        {
-            board.memory.ram[VirtualMemoryToPhysical(current_block_index)] = board.memory.ram[VirtualMemoryToPhysical(previous_free_block_index)];
+    }
+
+    Process *Kernel::Steal(Processor &processor)
+    {
+        processor_list_type::size_type count = processors.size();
+        if (count < 2) {
+            return NULL;
         }
-        if(previous_free_block_index + board.memory.ram[VirtualMemoryToPhysical(previous_free_block_index + 1)] == current_block_index)
-        {
-            board.memory.ram[VirtualMemoryToPhysical(previous_free_block_index + 1)] += board.memory.ram[VirtualMemoryToPhysical(current_block_index + 1)];
-            board.memory.ram[VirtualMemoryToPhysical(previous_free_block_index)] = board.memory.ram[VirtualMemoryToPhysical(current_block_index)];
+
+        // xorshift
+        processor.random_state ^= processor.random_state << 13;
+        processor.random_state ^= processor.random_state >> 17;
+        processor.random_state ^= processor.random_state << 5;
+        processor_list_type::size_type first = processor.random_state % count;
+
+        // Backlogs only shrink while the board runs. A failed steal means
+        //  another core took the process, the next round decides if there
+        //  is anything left.
+        for (;;) {
+            bool has_work = false;
+            for (processor_list_type::size_type i = 0; i < count; ++i) {
+                Processor &victim = *processors[(first + i) % count];
+                if (&victim == &processor || victim.backlog.IsEmpty()) {
+                    continue;
+                }
+                has_work = true;
+
+                Process *process = victim.backlog.Steal();
+                if (process != NULL) {
+                    SVM_TRACE_DEBUG("Kernel: core {} stole the process {} from the core {}",
+                                    processor.id, process->id, victim.id);
+
+                    ++processor.steal_count;
+
+                    return process;
+                }
+            }
+
+            if (!has_work) {
+                return NULL;
+            }
         }
-        else
-        {
-            board.memory.ram[VirtualMemoryToPhysical(previous_free_block_index)] = current_block_index;
+    }
+
+    void Kernel::Migrate(Processor &processor, Process &process)
+    {
+        if (process.cpu == processor.id) {
+            return;
         }
-        _free_physical_memory_index = previous_free_block_index;
+
+        Memory::ram_size_type size = process.memory_end_position - process.memory_start_position;
+        processor.core.cpu.InvalidateDecodedInstructions(process.memory_start_position, size);
+        processor.core.cpu.TranslateImage(process.memory_start_position, size);
+
+        process.cpu = processor.id;
+    }
+
+    void Kernel::ArmQuantum(Processor &processor)
+    {
+        Process *process = processor.processes.Running();
+        if (process != NULL) {
+            processor.core.pit.Arm(_quanta[std::min<std::size_t>(process->level, _quanta.size() - 1)]);
+        }
+    }
+
+    void Kernel::BoostIfDue(Processor &processor)
+    {
+        RunQueue &processes = processor.processes;
+        CPU::cycle_count_type now = processor.core.pit.Now();
+        if (now < processor.next_boost_time) {
+            return;
+        }
+
+        SVM_TRACE_DEBUG("Kernel: boosting the processes of the core {} to the first level", processor.id);
+
+        for (unsigned int level = 1; level < RunQueue::LEVEL_COUNT; ++level) {
+            while (!processes.Ready(level).IsEmpty()) {
+                processes.SetLevel(*processes.Ready(level).Front(), 0);
+            }
+        }
+
+        Process *process = processes.Running();
+        if (process != NULL) {
+            processes.SetLevel(*process, 0);
+        }
+
+        processor.next_boost_time = now + _BOOST_PERIOD;
     }
 }
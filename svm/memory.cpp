@@ -1,47 +1,40 @@
 #include "memory.h"
 
+#include <algorithm>
+
 namespace svm
 {
-    Memory::Memory()
-        : ram(RAM_SIZE)
+    Memory::Memory(ram_size_type ram_size, ram_size_type page_size)
+        : ram(),
+          frames((ram_size + (static_cast<ram_size_type>(1) << PageShift(page_size)) - 1) >> PageShift(page_size),
+                 static_cast<ram_size_type>(1) << PageShift(page_size)),
+          _page_shift(PageShift(page_size)),
+          _page_mask((static_cast<ram_size_type>(1) << _page_shift) - 1)
     {
-
-		for(page_entry_type frame = PAGE_SIZE; frame < RAM_SIZE; frame += PAGE_SIZE)
-		{
-			free_frames.push(frame);
-		}
+        ram.resize(frames.FrameCount() << _page_shift);
     }
 
     Memory::~Memory() {}
 
-    Memory::page_table_type* Memory::CreateEmptyPageTable()
+    void Memory::Reset()
     {
-		return new page_table_type(RAM_SIZE / PAGE_SIZE);
+        std::fill(ram.begin(), ram.end(), 0);
+        frames.Reset();
     }
 
-    Memory::page_index_offset_pair_type Memory::PageOffsetForVirtual(vmem_size_type address)
+    Memory::page_table_type* Memory::CreateEmptyPageTable(vmem_size_type size) const
     {
-        page_index_offset_pair_type result = std::make_pair((page_table_size_type) -1, (ram_size_type) -1);
-
-		result.first = address / PAGE_SIZE;
-		result.second = address % PAGE_SIZE;
-
-        return result;
+        return new page_table_type((size + _page_mask) >> _page_shift);
     }
 
-    Memory::page_entry_type Memory::AcquireFrame()
+    unsigned int Memory::PageShift(ram_size_type page_size)
     {
-		if(!free_frames.empty())
-		{
-			page_entry_type result = free_frames.top();
-			free_frames.pop();
-			return result;
-		}
-        return INVALID_PAGE;
-    }
+        unsigned int shift = 0;
+        while ((static_cast<ram_size_type>(1) << shift) < page_size ||
+                (static_cast<ram_size_type>(1) << shift) < MIN_PAGE_SIZE) {
+            ++shift;
+        }
 
-    void Memory::ReleaseFrame(page_entry_type page)
-    {
-		free_frames.push(page);
+        return shift;
     }
 }
@@ -0,0 +1,86 @@
+#include "page_table.h"
+
+namespace svm
+{
+    PageTable::Node::Node(bool is_leaf)
+        : entries(is_leaf ? FANOUT : 0, INVALID_ENTRY),
+          children(is_leaf ? 0 : FANOUT) { }
+
+    PageTable::PageTable(size_type page_count)
+        : _page_count(page_count),
+          _levels(1),
+          _root(),
+          _node_count(0),
+          _last_leaf_index(0),
+          _last_leaf(NULL)
+    {
+        while (_levels * LEVEL_BITS < sizeof(size_type) * 8 &&
+                (static_cast<size_type>(1) << (_levels * LEVEL_BITS)) < page_count) {
+            ++_levels;
+        }
+    }
+
+    PageTable::~PageTable() { }
+
+    bool PageTable::Map(size_type page, entry_type frame)
+    {
+        if (page >= _page_count) {
+            return false;
+        }
+
+        Node *leaf = FindLeaf(page, frame != INVALID_ENTRY);
+        if (leaf != NULL) {
+            leaf->entries[page & (FANOUT - 1)] = frame;
+        }
+
+        return true;
+    }
+
+    PageTable::size_type PageTable::MemoryUsage() const
+    {
+        // Leaves and upper nodes have the same number of slots
+        return sizeof(PageTable) +
+               _node_count * (sizeof(Node) + FANOUT * sizeof(entry_type));
+    }
+
+    PageTable::entry_type PageTable::Walk(size_type page)
+    {
+        if (page >= _page_count) {
+            return INVALID_ENTRY;
+        }
+
+        Node *leaf = FindLeaf(page, false);
+
+        return leaf != NULL ? leaf->entries[page & (FANOUT - 1)] : INVALID_ENTRY;
+    }
+
+    PageTable::Node *PageTable::FindLeaf(size_type page, bool create)
+    {
+        if (!_root) {
+            if (!create) {
+                return NULL;
+            }
+            _root.reset(new Node(_levels == 1));
+            ++_node_count;
+        }
+
+        Node *node = _root.get();
+        for (unsigned int level = _levels - 1; level > 0; --level) {
+            std::unique_ptr<Node> &child =
+                node->children[(page >> (LEVEL_BITS * level)) & (FANOUT - 1)];
+            if (!child) {
+                if (!create) {
+                    return NULL;
+                }
+                child.reset(new Node(level == 1));
+                ++_node_count;
+            }
+            node = child.get();
+        }
+
+        _last_leaf_index = page >> LEVEL_BITS;
+        _last_leaf = node;
+
+        return node;
+    }
+}
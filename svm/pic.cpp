@@ -3,23 +3,107 @@
 namespace svm
 {
     PIC::PIC()
-        : isr_0([]()  { }),
-          isr_1([]()  { }),
-          isr_2([]()  { }),
-          isr_3([]()  { }),
-          isr_4([]()  { }),
-          isr_5([]()  { }),
-          isr_6([]()  { }),
-          isr_7([]()  { }),
-          isr_8([]()  { }),
-          isr_9([]()  { }),
-          isr_10([]() { }),
-          isr_11([]() { }),
-          isr_12([]() { }),
-          isr_13([]() { }),
-          isr_14([]() { }),
-          isr_15([]() { }),
-          isr_16([]() { }) { }
-
-    PIC::~PIC() { }
+        : delivery_mode(Deferred),
+          _pending(0),
+          _masked(0),
+          _in_service(false)
+    {
+        for (unsigned int vector = 0; vector < VECTOR_COUNT; ++vector) {
+            _vectors[vector].isr = &PIC::Ignore;
+            _vectors[vector].context = NULL;
+            _vectors[vector].destructor = NULL;
+        }
+    }
+
+    PIC::~PIC()
+    {
+        for (unsigned int vector = 0; vector < VECTOR_COUNT; ++vector) {
+            Release(_vectors[vector]);
+        }
+    }
+
+    void PIC::DeliverPending()
+    {
+        if (_in_service) {
+            return;
+        }
+
+        _in_service = true;
+
+        unsigned int requests;
+        while ((requests = _pending & ~_masked) != 0) {
+            unsigned int vector = 0;
+            while ((requests & (1u << vector)) == 0) {
+                ++vector;
+            }
+
+            _pending &= ~(1u << vector);
+            Interrupt(vector);
+        }
+
+        _in_service = false;
+    }
+
+    void PIC::Reset()
+    {
+        for (unsigned int vector = 0; vector < VECTOR_COUNT; ++vector) {
+            Release(_vectors[vector]);
+        }
+
+        _pending = 0;
+        _masked = 0;
+        _in_service = false;
+    }
+
+    void PIC::Mask(unsigned int vector)
+    {
+        if (vector < VECTOR_COUNT) {
+            _masked |= 1u << vector;
+        }
+    }
+
+    void PIC::Unmask(unsigned int vector)
+    {
+        if (vector < VECTOR_COUNT) {
+            _masked &= ~(1u << vector);
+        }
+    }
+
+    bool PIC::IsMasked(unsigned int vector) const
+    {
+        return vector < VECTOR_COUNT && (_masked & (1u << vector)) != 0;
+    }
+
+    void PIC::SetISR(unsigned int vector, isr_type isr, void *context)
+    {
+        Install(vector, isr, context, NULL);
+    }
+
+    void PIC::Install(unsigned int vector, isr_type isr, void *context,
+                      destructor_type destructor)
+    {
+        if (vector < VECTOR_COUNT) {
+            Entry &entry = _vectors[vector];
+            Release(entry);
+
+            entry.isr = isr != NULL ? isr : &PIC::Ignore;
+            entry.context = context;
+            entry.destructor = destructor;
+        } else if (destructor != NULL) {
+            destructor(context);
+        }
+    }
+
+    void PIC::Release(Entry &entry)
+    {
+        if (entry.destructor != NULL) {
+            entry.destructor(entry.context);
+        }
+
+        entry.isr = &PIC::Ignore;
+        entry.context = NULL;
+        entry.destructor = NULL;
+    }
+
+    void PIC::Ignore(void *) { }
 }
@@ -4,6 +4,9 @@ namespace svm
 {
     PIT::PIT(PIC &pic)
         : frequency(DEFAULT_FREQUENCY),
+          _mode(Periodic),
+          _now(0),
+          _deadline(NO_DEADLINE),
           _passed_cycles_count(0),
           _pic(pic) { }
 
@@ -11,11 +14,72 @@ namespace svm
 
     void PIT::Tick()
     {
-        ++_passed_cycles_count;
+        ++_now;
 
-        if (_passed_cycles_count >= frequency) {
-            _pic.isr_0();
-            _passed_cycles_count = 0;
+        if (_mode == Periodic) {
+            ++_passed_cycles_count;
+
+            if (_passed_cycles_count >= frequency) {
+                _pic.Raise(PIC::TIMER_VECTOR);
+                _passed_cycles_count = 0;
+            }
+        } else if (_now >= _deadline) {
+            _deadline = NO_DEADLINE;
+            _pic.Raise(PIC::TIMER_VECTOR);
+        }
+    }
+
+    void PIT::Arm(cycle_count_type cycles)
+    {
+        _mode = OneShot;
+        _deadline = cycles < NO_DEADLINE - _now ? _now + cycles : NO_DEADLINE;
+    }
+
+    void PIT::Disarm()
+    {
+        _mode = OneShot;
+        _deadline = NO_DEADLINE;
+    }
+
+    void PIT::Reset()
+    {
+        frequency = DEFAULT_FREQUENCY;
+        _mode = Periodic;
+        _now = 0;
+        _deadline = NO_DEADLINE;
+        _passed_cycles_count = 0;
+    }
+
+    PIT::Mode PIT::GetMode() const
+    {
+        return _mode;
+    }
+
+    PIT::cycle_count_type PIT::Now() const
+    {
+        return _now;
+    }
+
+    PIT::cycle_count_type PIT::CyclesUntilInterrupt() const
+    {
+        if (_mode == Periodic) {
+            return _passed_cycles_count < frequency ?
+                       frequency - _passed_cycles_count : 1;
+        }
+
+        if (_deadline == NO_DEADLINE) {
+            return NO_DEADLINE;
+        }
+
+        return _deadline > _now ? _deadline - _now : 1;
+    }
+
+    void PIT::Advance(cycle_count_type cycles)
+    {
+        _now += cycles;
+
+        if (_mode == Periodic) {
+            _passed_cycles_count += static_cast<frequency_type>(cycles);
         }
     }
 }
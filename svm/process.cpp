@@ -1,18 +1,35 @@
 #include "process.h"
 
+#include "process_heap.h"
+
 namespace svm
 {
     Process::Process(process_id_type id, Memory::ram_size_type memory_start_position,
-                                         Memory::ram_size_type memory_end_position)
+                                         Memory::ram_size_type memory_end_position,
+                                         Memory::page_table_type *page_table)
         : id(id), registers(), state(Ready), priority(0),
           memory_start_position(memory_start_position),
-          memory_end_position(memory_end_position)
+          memory_end_position(memory_end_position),
+          arrival_time(0),
+          burst_start_time(0),
+          cpu_time(0),
+          page_table(page_table),
+          swap_slots(),
+          page_fault_count(0),
+          swap_in_count(0),
+          swap_out_count(0),
+          copy_on_write_count(0),
+          _DYNAMIC_MAX_CYCLES_BEFORE_PREEMPTION(100),
+          level(0),
+          cpu(0),
+          previous(NULL),
+          next(NULL),
+          heap_index(ProcessHeap::INVALID_INDEX)
     {
         registers.ip = memory_start_position;
 
         sequential_instruction_count = (memory_end_position - memory_start_position) / 2;
-
-        page_table = Memory::CreateEmptyPageTable();
+        predicted_burst = sequential_instruction_count;
     }
 
     Process::~Process()
@@ -20,10 +37,16 @@ namespace svm
         delete page_table;
     }
 
-    bool Process::operator<(const Process &anotherProcess) const {
-        return priority < anotherProcess.priority;
-    }
     void Process::updateCycles() {
 		_DYNAMIC_MAX_CYCLES_BEFORE_PREEMPTION = priority * 100 + 100;
 	}
+
+    void Process::EndBurst(CPU::cycle_count_type time)
+    {
+        CPU::cycle_count_type burst = time - burst_start_time;
+        cpu_time += burst;
+
+        // alpha = 1/2
+        predicted_burst = burst / 2 + predicted_burst / 2;
+    }
 }
@@ -0,0 +1,87 @@
+#include "process_heap.h"
+
+namespace svm
+{
+    ProcessHeap::ProcessHeap(Order order)
+        : _order(order),
+          _entries(),
+          _next_sequence(0) { }
+
+    ProcessHeap::~ProcessHeap() { }
+
+    void ProcessHeap::Push(Process &process)
+    {
+        Entry entry;
+        entry.process = &process;
+        entry.sequence = _next_sequence++;
+
+        _entries.push_back(entry);
+        process.heap_index = _entries.size() - 1;
+
+        SiftUp(process.heap_index);
+    }
+
+    void ProcessHeap::Remove(Process &process)
+    {
+        size_type index = process.heap_index;
+        process.heap_index = INVALID_INDEX;
+
+        Entry last = _entries.back();
+        _entries.pop_back();
+
+        if (index < _entries.size()) {
+            Place(last, index);
+            SiftUp(index);
+            SiftDown(last.process->heap_index);
+        }
+    }
+
+    void ProcessHeap::Update(Process &process)
+    {
+        SiftUp(process.heap_index);
+        SiftDown(process.heap_index);
+    }
+
+    void ProcessHeap::SiftUp(size_type index)
+    {
+        Entry entry = _entries[index];
+        while (index > 0) {
+            size_type parent = (index - 1) / 2;
+            if (!IsBefore(entry, _entries[parent])) {
+                break;
+            }
+
+            Place(_entries[parent], index);
+            index = parent;
+        }
+        Place(entry, index);
+    }
+
+    void ProcessHeap::SiftDown(size_type index)
+    {
+        Entry entry = _entries[index];
+        for (;;) {
+            size_type child = index * 2 + 1;
+            if (child >= _entries.size()) {
+                break;
+            }
+            if (child + 1 < _entries.size() &&
+                    IsBefore(_entries[child + 1], _entries[child])) {
+                ++child;
+            }
+            if (!IsBefore(_entries[child], entry)) {
+                break;
+            }
+
+            Place(_entries[child], index);
+            index = child;
+        }
+        Place(entry, index);
+    }
+
+    void ProcessHeap::Place(const Entry &entry, size_type index)
+    {
+        _entries[index] = entry;
+        entry.process->heap_index = index;
+    }
+}
@@ -0,0 +1,175 @@
+#include "run_queue.h"
+
+namespace svm
+{
+    ProcessList::ProcessList()
+        : _front(NULL),
+          _back(NULL),
+          _size(0) { }
+
+    ProcessList::~ProcessList() { }
+
+    void ProcessList::PushBack(Process &process)
+    {
+        process.previous = _back;
+        process.next = NULL;
+
+        if (_back != NULL) {
+            _back->next = &process;
+        } else {
+            _front = &process;
+        }
+        _back = &process;
+
+        ++_size;
+    }
+
+    void ProcessList::PushFront(Process &process)
+    {
+        process.previous = NULL;
+        process.next = _front;
+
+        if (_front != NULL) {
+            _front->previous = &process;
+        } else {
+            _back = &process;
+        }
+        _front = &process;
+
+        ++_size;
+    }
+
+    void ProcessList::Remove(Process &process)
+    {
+        if (process.previous != NULL) {
+            process.previous->next = process.next;
+        } else {
+            _front = process.next;
+        }
+
+        if (process.next != NULL) {
+            process.next->previous = process.previous;
+        } else {
+            _back = process.previous;
+        }
+
+        process.previous = process.next = NULL;
+
+        --_size;
+    }
+
+    Process *ProcessList::PopFront()
+    {
+        Process *process = _front;
+        if (process != NULL) {
+            Remove(*process);
+        }
+
+        return process;
+    }
+
+    RunQueue::RunQueue(ProcessHeap::Order order)
+        : _processes(),
+          _ready_levels(0),
+          _ready_count(0),
+          _running(),
+          _blocked(),
+          _ready_heap(order) { }
+
+    RunQueue::~RunQueue() { }
+
+    Process &RunQueue::Add(Process *process)
+    {
+        if (process->id >= _processes.size()) {
+            _processes.resize(process->id + 1);
+        }
+        _processes[process->id].reset(process);
+
+        process->state = Process::Ready;
+        Link(*process);
+
+        return *process;
+    }
+
+    Process *RunQueue::Find(handle_type id) const
+    {
+        return id < _processes.size() ? _processes[id].get() : NULL;
+    }
+
+    void RunQueue::SetState(Process &process, Process::States state)
+    {
+        Unlink(process);
+
+        process.state = state;
+        Link(process);
+    }
+
+    void RunQueue::Terminate(Process &process)
+    {
+        Unlink(process);
+
+        _processes[process.id].reset();
+    }
+
+    void RunQueue::SetPriority(Process &process,
+                               Process::process_priority_type priority)
+    {
+        process.priority = priority;
+        if (process.state == Process::Ready) {
+            _ready_heap.Update(process);
+        }
+    }
+
+    void RunQueue::SetLevel(Process &process, unsigned int level)
+    {
+        if (process.state == Process::Ready) {
+            Unlink(process);
+            process.level = level;
+            Link(process);
+        } else {
+            process.level = level;
+        }
+    }
+
+    void RunQueue::Link(Process &process)
+    {
+        switch (process.state)
+        {
+            case Process::Running:
+                _running.PushBack(process);
+                break;
+            case Process::Blocked:
+                _blocked.PushBack(process);
+                break;
+            default:
+                _ready[process.level].PushBack(process);
+                _ready_levels |= 1u << process.level;
+                ++_ready_count;
+
+                _ready_heap.Push(process);
+                break;
+        }
+    }
+
+    void RunQueue::Unlink(Process &process)
+    {
+        switch (process.state)
+        {
+            case Process::Running:
+                _running.Remove(process);
+                break;
+            case Process::Blocked:
+                _blocked.Remove(process);
+                break;
+            default:
+                _ready[process.level].Remove(process);
+                if (_ready[process.level].IsEmpty()) {
+                    _ready_levels &= ~(1u << process.level);
+                }
+                --_ready_count;
+
+                _ready_heap.Remove(process);
+                break;
+        }
+    }
+}
@@ -0,0 +1,100 @@
+#include "sequence_profile.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "cpu.h"
+
+namespace svm
+{
+    namespace
+    {
+        const char *Mnemonic(unsigned int opcode)
+        {
+            switch (opcode)
+            {
+                case CPU::MOVA_OPCODE:     return "mov a";
+                case CPU::MOVB_OPCODE:     return "mov b";
+                case CPU::MOVC_OPCODE:     return "mov c";
+                case CPU::JMP_OPCODE:      return "jmp";
+                case CPU::INT_OPCODE:      return "int";
+                case CPU::LDA_BASE_OPCODE: return "ld a";
+                case CPU::LDB_BASE_OPCODE: return "ld b";
+                case CPU::LDC_BASE_OPCODE: return "ld c";
+                case CPU::STA_BASE_OPCODE: return "st a";
+                case CPU::STB_BASE_OPCODE: return "st b";
+                case CPU::STC_BASE_OPCODE: return "st c";
+                default:                   return "?";
+            }
+        }
+    }
+
+    SequenceProfile::SequenceProfile()
+        : _pairs(),
+          _triples(),
+          _recorded(0),
+          _previous(0) { }
+
+    SequenceProfile::~SequenceProfile() { }
+
+    void SequenceProfile::Record(int opcode)
+    {
+        unsigned int sequence =
+            ((_previous << 8) | (static_cast<unsigned int>(opcode) & 0xFF)) &
+                0xFFFFFF;
+
+        if (_recorded >= 1) {
+            ++_pairs[sequence & 0xFFFF];
+        }
+        if (_recorded >= 2) {
+            ++_triples[sequence];
+        }
+
+        ++_recorded;
+        _previous = sequence & 0xFFFF;
+    }
+
+    void SequenceProfile::Report(std::ostream &stream, std::size_t limit) const
+    {
+        stream << "Hottest instruction pairs:" << std::endl;
+        ReportSequences(stream, _pairs, 2, _recorded, limit);
+
+        stream << "Hottest instruction triples:" << std::endl;
+        ReportSequences(stream, _triples, 3, _recorded, limit);
+    }
+
+    bool SequenceProfile::IsEmpty() const
+    {
+        return _recorded == 0;
+    }
+
+    void SequenceProfile::ReportSequences(std::ostream &stream,
+                                          const sequences_type &sequences,
+                                          unsigned int length,
+                                          counter_type total,
+                                          std::size_t limit)
+    {
+        std::vector<std::pair<counter_type, unsigned int> > sorted;
+        for (sequences_type::const_iterator it = sequences.begin();
+                it != sequences.end(); ++it) {
+            sorted.push_back(std::make_pair(it->second, it->first));
+        }
+        std::sort(sorted.rbegin(), sorted.rend());
+
+        if (sorted.size() > limit) {
+            sorted.resize(limit);
+        }
+
+        for (std::size_t i = 0; i < sorted.size(); ++i) {
+            stream << "  ";
+            for (unsigned int j = length; j > 0; --j) {
+                stream << Mnemonic((sorted[i].second >> ((j - 1) * 8)) & 0xFF)
+                       << (j > 1 ? ", " : "");
+            }
+            stream << ": " << sorted[i].first
+                   << " (" << (100.0 * sorted[i].first / total) << "%)"
+                   << std::endl;
+        }
+    }
+}
@@ -1,67 +1,26 @@
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iterator>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <cstdlib>
 
 #include "kernel.h"
+#include "trace.h"
 
 namespace svm
 {
-    Memory::ram_type *LoadExecutable(const std::string &name)
+    // Scheduler argument, e.g., `/scheduler:rr` or `/scheduler:mlfq:5,10`.
+    //  Returns `Kernel::Undefined` for an unknown one.
+    Kernel::Scheduler ParseScheduler(const std::string &argument,
+                                     Kernel::quantum_list_type &quanta)
     {
-        Memory::ram_type *result =
-            NULL;
-
-        std::ifstream
-            input_stream(
-                name,
-                std::ios::in |
-                    std::ios::binary
-            );
-
-        if (input_stream) {
-            result =
-                new Memory::ram_type();
-
-            input_stream.seekg(
-                0, std::ios::end
-            );
-            auto file_size =
-                input_stream.tellg();
-            input_stream.seekg(
-                0, std::ios::beg
-            );
-
-            result->resize(
-                static_cast<Memory::ram_size_type>(file_size) / 4
-            );
-            input_stream.read(
-                reinterpret_cast<char *>(&(*result)[0]),
-                file_size
-            );
-
-            if (input_stream.bad()) {
-                delete result;
-                result = NULL;
-
-                std::cerr << "SVM: failed to read the program file."
-                          << std::endl;
-            }
-        } else {
-            std::cerr << "SVM: failed to open the program file."
-                      << std::endl;
-        }
-
-        return result;
-    }
-}
-
-int main(int argc, char *argv[])
-{
-    using namespace svm;
-
-    if (argc > 2) {
-        std::string argument(argv[1]);
-
         Kernel::Scheduler scheduler;
         if (argument == "/scheduler:fcfs") {
             scheduler =
@@ -75,28 +34,375 @@ int main(int argc, char *argv[])
         } else if (argument == "/scheduler:priority") {
             scheduler =
                 Kernel::Priority;
+        } else if (argument == "/scheduler:srtf") {
+            scheduler =
+                Kernel::ShortestRemainingTime;
+        } else if (argument.compare(0, 15, "/scheduler:mlfq") == 0 &&
+                   (argument.size() == 15 || argument[15] == ':')) {
+            scheduler =
+                Kernel::MultilevelFeedbackQueue;
+
+            // Optional quanta of the levels: /scheduler:mlfq:5,10,20
+            std::string::size_type position = 16;
+            while (position < argument.size()) {
+                std::string::size_type end = argument.find(',', position);
+                if (end == std::string::npos) {
+                    end = argument.size();
+                }
+
+                quanta.push_back(std::strtoull(
+                    argument.substr(position, end - position).c_str(), NULL, 10));
+
+                position = end + 1;
+            }
         } else {
             scheduler =
                 Kernel::Undefined;
         }
 
-        std::vector<Memory::ram_type> processes;
-        for (int i = 2; i < argc; ++i) {
-            Memory::ram_type *executable = LoadExecutable(argv[i]);
+        return scheduler;
+    }
+
+    // Parses `/<name>:<count>` into `count`, returns false for other
+    //  arguments
+    bool ParseCount(const std::string &argument, const std::string &name,
+                    unsigned int &count)
+    {
+        std::string prefix = "/" + name + ":";
+        if (argument.compare(0, prefix.size(), prefix) != 0) {
+            return false;
+        }
+
+        count = static_cast<unsigned int>(
+            std::strtoul(argument.c_str() + prefix.size(), NULL, 10));
+        if (count == 0) {
+            std::cerr << "SVM: invalid number in " << argument
+                      << ". Using one..." << std::endl;
+            count = 1;
+        }
+
+        return true;
+    }
+
+    // Parses `/<name>:<size>` with an optional `K`, `M` or `G` suffix
+    //  (binary) into `size`, returns false for other arguments
+    bool ParseSize(const std::string &argument, const std::string &name,
+                   Memory::ram_size_type &size)
+    {
+        std::string prefix = "/" + name + ":";
+        if (argument.compare(0, prefix.size(), prefix) != 0) {
+            return false;
+        }
+
+        char *end = NULL;
+        Memory::ram_size_type value =
+            std::strtoull(argument.c_str() + prefix.size(), &end, 10);
+        switch (*end)
+        {
+            case 'K': case 'k': value <<= 10; break;
+            case 'M': case 'm': value <<= 20; break;
+            case 'G': case 'g': value <<= 30; break;
+            default: break;
+        }
+
+        if (value == 0) {
+            std::cerr << "SVM: invalid size in " << argument
+                      << ". Using the default..." << std::endl;
+        } else {
+            size = value;
+        }
+
+        return true;
+    }
+
+    // Parses `/paging:clock`, `/paging:aging` or `/paging:ws[:<window>]`
+    //  (working set with the window in cycles), returns false for other
+    //  arguments
+    bool ParseReplacement(const std::string &argument,
+                          Kernel::Replacement &replacement,
+                          CPU::cycle_count_type &working_set_window)
+    {
+        static const std::string PREFIX = "/paging:";
+        if (argument.compare(0, PREFIX.size(), PREFIX) != 0) {
+            return false;
+        }
+
+        std::string policy = argument.substr(PREFIX.size());
+        if (policy == "clock") {
+            replacement = Kernel::Clock;
+        } else if (policy == "aging") {
+            replacement = Kernel::Aging;
+        } else if (policy.compare(0, 2, "ws") == 0 &&
+                   (policy.size() == 2 || policy[2] == ':')) {
+            replacement = Kernel::WorkingSet;
+            if (policy.size() > 3) {
+                working_set_window = std::strtoull(policy.c_str() + 3, NULL, 10);
+            }
+        } else {
+            std::cerr << "SVM: invalid replacement policy in " << argument
+                      << ". Using clock..." << std::endl;
+            replacement = Kernel::Clock;
+        }
+
+        return true;
+    }
+
+    // One set of programs for a kernel, the arguments of an `svm` call
+    //  (`<scheduler> [/cpus:<N>] [/ram:<size>] [/page:<size>]
+    //  [/swap:<size>] [/paging:<policy>] <.vmexe file>...`) or a line of
+    //  a fleet manifest
+    struct Job
+    {
+        Kernel::Scheduler scheduler;
+        Kernel::quantum_list_type quanta;
+        unsigned int core_count;
+        Memory::ram_size_type ram_size;  // In cells
+        Memory::ram_size_type page_size;
+        SwapSpace::size_type swap_size;
+        Kernel::Replacement replacement;
+        CPU::cycle_count_type working_set_window;
+        std::vector<std::string> processes;
+
+        Job() : scheduler(Kernel::Undefined), quanta(), core_count(1),
+                ram_size(Memory::DEFAULT_RAM_SIZE),
+                page_size(Memory::DEFAULT_PAGE_SIZE),
+                swap_size(SwapSpace::DEFAULT_SIZE),
+                replacement(Kernel::Clock),
+                working_set_window(Kernel::DEFAULT_WORKING_SET_WINDOW),
+                processes() { }
+    };
+
+    Job ParseJob(const std::vector<std::string> &arguments)
+    {
+        Job job;
+        if (!arguments.empty()) {
+            job.scheduler = ParseScheduler(arguments[0], job.quanta);
+        }
+
+        for (std::vector<std::string>::size_type i = 1;
+                i < arguments.size(); ++i) {
+            // Number of virtual CPUs of the board: /cpus:4, size of the
+            //  RAM, of the pages and of the swap space in cells: /ram:16M
+            //  /page:4K /swap:64M, page replacement: /paging:ws:200
+            if (!ParseCount(arguments[i], "cpus", job.core_count) &&
+                    !ParseSize(arguments[i], "ram", job.ram_size) &&
+                    !ParseSize(arguments[i], "page", job.page_size) &&
+                    !ParseSize(arguments[i], "swap", job.swap_size) &&
+                    !ParseReplacement(arguments[i], job.replacement,
+                                      job.working_set_window)) {
+                job.processes.push_back(arguments[i]);
+            }
+        }
+
+        return job;
+    }
+
+    // Fleet Mode
+    //
+    // Runs every job of the manifest (one job per line in the format of the
+    //  `svm` arguments, `#` starts a comment) on a pool of host threads.
+    //  Every thread keeps its kernels and reuses them for the following
+    //  jobs. A line per job is appended to the output as soon as the job
+    //  finishes:
+    //
+    //      <job> <finished>/<processes> <average turnaround> <average waiting>
+    //            <id>:<a>,<b>,<c>,<ip> ...
+    //
+    //  with the exit registers of every finished process. Jobs are numbered
+    //  from 0 in the order of the manifest lines.
+    int RunFleet(const std::string &manifest_name,
+                 const std::string &output_name,
+                 unsigned int thread_count)
+    {
+        std::ifstream manifest(manifest_name);
+        if (!manifest) {
+            std::cerr << "SVM: failed to open the fleet manifest."
+                      << std::endl;
+
+            return -1;
+        }
+
+        std::vector<Job> jobs;
+        std::string line;
+        while (std::getline(manifest, line)) {
+            std::string::size_type comment = line.find('#');
+            if (comment != std::string::npos) {
+                line.erase(comment);
+            }
+
+            std::istringstream words(line);
+            std::vector<std::string> arguments(
+                (std::istream_iterator<std::string>(words)),
+                std::istream_iterator<std::string>());
+            if (!arguments.empty()) {
+                jobs.push_back(ParseJob(arguments));
+            }
+        }
+
+        std::ofstream output(output_name);
+        if (!output) {
+            std::cerr << "SVM: failed to open the fleet output."
+                      << std::endl;
+
+            return -1;
+        }
+
+        // Every file is mapped once for all jobs
+        std::map<std::string, std::shared_ptr<const Executable> > executables;
+        for (std::vector<Job>::const_iterator job = jobs.begin();
+                job != jobs.end(); ++job) {
+            for (std::vector<std::string>::const_iterator it = job->processes.begin();
+                    it != job->processes.end(); ++it) {
+                if (executables.find(*it) == executables.end()) {
+                    executables[*it] = Executable::Open(*it);
+                }
+            }
+        }
+
+        std::atomic<std::vector<Job>::size_type> next_job(0);
+        std::mutex output_mutex;
+
+        auto work = [&]() {
+            // One kernel per board configuration
+            typedef std::tuple<unsigned int, Memory::ram_size_type,
+                               Memory::ram_size_type, SwapSpace::size_type>
+                        configuration_type;
+            std::map<configuration_type, std::unique_ptr<Kernel> > kernels;
+
+            std::ostringstream record;
+            for (std::vector<Job>::size_type index = next_job++;
+                    index < jobs.size(); index = next_job++) {
+                const Job &job = jobs[index];
+
+                record.str("");
+                record << index;
+                if (job.scheduler == Kernel::Undefined) {
+                    record << " invalid scheduler";
+                } else if (job.processes.empty()) {
+                    record << " nothing to run";
+                } else {
+                    std::unique_ptr<Kernel> &kernel =
+                        kernels[configuration_type(job.core_count, job.ram_size,
+                                                   job.page_size, job.swap_size)];
+                    if (!kernel) {
+                        kernel.reset(new Kernel(job.core_count, job.ram_size,
+                                                job.page_size, job.swap_size));
+                    }
+                    kernel->Run(job.scheduler, job.processes, job.quanta,
+                                job.replacement, job.working_set_window);
+
+                    Kernel::result_list_type results = kernel->Results();
+                    CPU::cycle_count_type turnaround_time = 0;
+                    CPU::cycle_count_type waiting_time = 0;
+                    for (Kernel::result_list_type::const_iterator it = results.begin();
+                            it != results.end(); ++it) {
+                        turnaround_time += it->turnaround_time;
+                        waiting_time += it->waiting_time;
+                    }
+
+                    record << ' ' << results.size() << '/' << kernel->ProcessCount()
+                           << ' ' << (results.empty() ? 0.0 :
+                                          static_cast<double>(turnaround_time) / results.size())
+                           << ' ' << (results.empty() ? 0.0 :
+                                          static_cast<double>(waiting_time) / results.size());
+                    for (Kernel::result_list_type::const_iterator it = results.begin();
+                            it != results.end(); ++it) {
+                        record << ' ' << it->id << ':' << it->registers.a
+                               << ',' << it->registers.b
+                               << ',' << it->registers.c
+                               << ',' << it->registers.ip;
+                    }
+                }
+                record << '\n';
+
+                std::lock_guard<std::mutex> lock(output_mutex);
+                output << record.str();
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned int i = 1; i < thread_count; ++i) {
+            threads.push_back(std::thread(work));
+        }
+        work();
+
+        for (std::vector<std::thread>::iterator it = threads.begin();
+                it != threads.end(); ++it) {
+            it->join();
+        }
+
+        output.flush();
+        if (!output) {
+            std::cerr << "SVM: failed to write the fleet output."
+                      << std::endl;
+
+            return -1;
+        }
+
+        return 0;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    using namespace svm;
+
+    // The trace level can be lowered at run time, levels above the one the
+    //  SVM was built with are compiled out
+    const char *trace_level = std::getenv("SVM_TRACE");
+    if (trace_level) {
+        Trace::Level level;
+        if (Trace::ParseLevel(trace_level, level)) {
+            Trace::SetLevel(level);
+        } else {
+            std::cerr << "SVM: invalid trace level. Ignoring..."
+                      << std::endl;
+        }
+    }
+
+    if (argc > 2) {
+        std::string argument(argv[1]);
+
+        // svm /fleet:<manifest> <output> [/threads:<N>]
+        if (argument.compare(0, 7, "/fleet:") == 0) {
+            unsigned int thread_count = std::thread::hardware_concurrency();
+            if (thread_count == 0) {
+                thread_count = 1;
+            }
+            if (argc > 3 && !ParseCount(argv[3], "threads", thread_count)) {
+                std::cerr << "SVM: unknown fleet option. Exiting..."
+                          << std::endl;
+
+                return -1;
+            }
+
+            return RunFleet(argument.substr(7), argv[2], thread_count);
+        }
+
+        Job job = ParseJob(std::vector<std::string>(argv + 1, argv + argc));
+
+        // The files stay mapped for the kernel
+        std::vector<std::string> processes;
+        std::vector<std::shared_ptr<const Executable> > executables;
+        for (std::vector<std::string>::const_iterator it = job.processes.begin();
+                it != job.processes.end(); ++it) {
+            std::shared_ptr<const Executable> executable = Executable::Open(*it);
             if (executable) {
-                processes.push_back(*executable);
-                delete executable;
+                processes.push_back(*it);
+                executables.push_back(executable);
             }
         }
 
-        if (scheduler == Kernel::Undefined) {
+        if (job.scheduler == Kernel::Undefined) {
             std::cerr << "SVM: invalid scheduler selection. Exiting..."
                       << std::endl;
         } else if (processes.empty()) {
             std::cerr << "SVM: nothing to run. Exiting..."
                       << std::endl;
         } else {
-            Kernel kernel(scheduler, processes);
+            Kernel kernel(job.scheduler, processes, job.quanta, job.core_count,
+                          job.ram_size, job.page_size, job.swap_size,
+                          job.replacement, job.working_set_window);
         }
     }
 
@@ -0,0 +1,65 @@
+#include "swap_space.h"
+
+#include <algorithm>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <sys/mman.h>
+    #define SVM_SWAP_MMAP
+#endif
+
+namespace svm
+{
+    SwapSpace::SwapSpace(size_type size, size_type page_size)
+        : _slots((size + page_size - 1) / page_size + 1, page_size),
+          _cells(NULL),
+          _cell_count(_slots.FrameCount() * page_size)
+    {
+#if defined(SVM_SWAP_MMAP)
+        void *cells = mmap(NULL, _cell_count * sizeof(int),
+                           PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (cells == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        _cells = static_cast<int *>(cells);
+#else
+        _cells = new int[_cell_count];
+#endif
+    }
+
+    SwapSpace::~SwapSpace()
+    {
+#if defined(SVM_SWAP_MMAP)
+        munmap(_cells, _cell_count * sizeof(int));
+#else
+        delete[] _cells;
+#endif
+    }
+
+    SwapSpace::slot_type SwapSpace::Acquire()
+    {
+        return _slots.Acquire();
+    }
+
+    void SwapSpace::Release(slot_type slot)
+    {
+        _slots.Release(slot);
+    }
+
+    void SwapSpace::Write(slot_type slot, const int *page)
+    {
+        std::copy(page, page + _slots.FrameSize(), _cells + slot);
+    }
+
+    void SwapSpace::Read(slot_type slot, int *page) const
+    {
+        std::copy(_cells + slot, _cells + slot + _slots.FrameSize(), page);
+    }
+
+    void SwapSpace::Reset()
+    {
+        // The contents of free slots are never read
+        _slots.Reset();
+    }
+}
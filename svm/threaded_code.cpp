@@ -0,0 +1,81 @@
+#include "threaded_code.h"
+
+namespace svm
+{
+    ThreadedCode::ThreadedCode()
+        : _translations(),
+          _last(_translations.end()),
+          _lowest(0),
+          _highest(0) { }
+
+    ThreadedCode::~ThreadedCode() { }
+
+    void ThreadedCode::Add(Memory::ram_size_type address, code_type &code)
+    {
+        Invalidate(address, code.size() * 2);
+
+        if (!code.empty()) {
+            _translations[address].swap(code);
+            _last = _translations.end();
+
+            UpdateBounds();
+        }
+    }
+
+    const ThreadedInstruction *ThreadedCode::FindTranslation(
+                                                Memory::ram_size_type address)
+    {
+        translations_type::iterator it = _translations.upper_bound(address);
+        if (it == _translations.begin()) {
+            return NULL;
+        }
+        --it;
+
+        if (address >= it->first + it->second.size() * 2) {
+            return NULL;
+        }
+
+        _last = it;
+
+        return Instruction(it, address);
+    }
+
+    bool ThreadedCode::InvalidateTranslations(Memory::ram_size_type address,
+                                              Memory::ram_size_type size)
+    {
+        bool invalidated = false;
+
+        translations_type::iterator it = _translations.upper_bound(address);
+        if (it != _translations.begin()) {
+            --it;
+        }
+
+        while (it != _translations.end() && it->first < address + size) {
+            if (address < it->first + it->second.size() * 2) {
+                it = _translations.erase(it);
+                invalidated = true;
+            } else {
+                ++it;
+            }
+        }
+
+        if (invalidated) {
+            _last = _translations.end();
+            UpdateBounds();
+        }
+
+        return invalidated;
+    }
+
+    void ThreadedCode::UpdateBounds()
+    {
+        if (_translations.empty()) {
+            _lowest = _highest = 0;
+        } else {
+            translations_type::reverse_iterator last = _translations.rbegin();
+
+            _lowest = _translations.begin()->first;
+            _highest = last->first + last->second.size() * 2;
+        }
+    }
+}
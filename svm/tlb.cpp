@@ -0,0 +1,42 @@
+#include "tlb.h"
+
+namespace svm
+{
+    TLB::TLB(Memory::page_table_size_type size)
+        : hits(0),
+          misses(0),
+          _entries(size),
+          _mask(size - 1)
+    {
+        Flush();
+    }
+
+    TLB::~TLB() { }
+
+    void TLB::Invalidate(Memory::address_space_type address_space,
+                         Memory::page_table_size_type page)
+    {
+        Entry &entry = _entries[page & _mask];
+        if (entry.address_space == address_space && entry.page == page) {
+            entry.address_space = _INVALID_ADDRESS_SPACE;
+        }
+    }
+
+    void TLB::Flush(Memory::address_space_type address_space)
+    {
+        for (std::vector<Entry>::iterator it = _entries.begin();
+                it != _entries.end(); ++it) {
+            if (it->address_space == address_space) {
+                it->address_space = _INVALID_ADDRESS_SPACE;
+            }
+        }
+    }
+
+    void TLB::Flush()
+    {
+        for (std::vector<Entry>::iterator it = _entries.begin();
+                it != _entries.end(); ++it) {
+            it->address_space = _INVALID_ADDRESS_SPACE;
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#include "trace.h"
+
+#include <cstring>
+
+namespace svm
+{
+    std::array<Trace::Record, Trace::CAPACITY> Trace::_records;
+    std::atomic<Trace::sequence_type> Trace::_next(0);
+    std::atomic<int> Trace::_level(SVM_TRACE_LEVEL);
+
+    Trace::sequence_type Trace::_dumped = 0;
+
+    void Trace::SetLevel(Level level)
+    {
+        _level.store(level, std::memory_order_relaxed);
+    }
+
+    Trace::Level Trace::GetLevel()
+    {
+        return static_cast<Level>(_level.load(std::memory_order_relaxed));
+    }
+
+    bool Trace::ParseLevel(const char *name, Level &level)
+    {
+        static const char *NAMES[] = { "none", "error", "info", "debug" };
+
+        for (int i = None; i <= Debug; ++i) {
+            if (std::strcmp(name, NAMES[i]) == 0) {
+                level = static_cast<Level>(i);
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void Trace::Dump(std::ostream &stream)
+    {
+        static const char *PREFIXES[] = { "", "[error] ", "[info] ", "[debug] " };
+
+        sequence_type next = _next.load(std::memory_order_acquire);
+
+        sequence_type lost = 0;
+        if (next - _dumped > CAPACITY) {
+            lost = next - CAPACITY - _dumped;
+            _dumped = next - CAPACITY;
+        }
+
+        for (; _dumped < next; ++_dumped) {
+            const Record &record = _records[_dumped & (CAPACITY - 1)];
+
+            sequence_type written =
+                record.sequence.load(std::memory_order_acquire);
+            if (written < _dumped + 1) {
+                // Still being written, picked up by the next dump
+                break;
+            }
+
+            Level level = record.level;
+            const char *format = record.format;
+            argument_type arguments[MAX_ARGUMENTS];
+            for (unsigned int i = 0; i < MAX_ARGUMENTS; ++i) {
+                arguments[i] = record.arguments[i];
+            }
+
+            // Overwritten by a writer that wrapped around the buffer
+            if (written != _dumped + 1 ||
+                    record.sequence.load(std::memory_order_acquire) != written) {
+                ++lost;
+                continue;
+            }
+
+            stream << PREFIXES[level];
+            Format(stream, format, arguments);
+            stream << '\n';
+        }
+
+        if (lost > 0) {
+            stream << "Trace: " << lost << " records lost\n";
+        }
+
+        stream.flush();
+    }
+
+    void Trace::Format(std::ostream &stream, const char *format,
+                       const argument_type *arguments)
+    {
+        unsigned int argument = 0;
+        for (const char *c = format; *c != '\0'; ++c) {
+            if (c[0] == '{' && c[1] == '}' && argument < MAX_ARGUMENTS) {
+                stream << arguments[argument++];
+                ++c;
+            } else {
+                stream << *c;
+            }
+        }
+    }
+}
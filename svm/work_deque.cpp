@@ -0,0 +1,96 @@
+#include "work_deque.h"
+
+namespace svm
+{
+    WorkDeque::Buffer::Buffer(index_type capacity)
+        : mask(capacity - 1),
+          cells(new std::atomic<Process *>[capacity]) { }
+
+    WorkDeque::WorkDeque()
+        : _top(0),
+          _bottom(0),
+          _buffer(NULL),
+          _buffers()
+    {
+        _buffers.push_back(std::unique_ptr<Buffer>(new Buffer(INITIAL_CAPACITY)));
+        _buffer.store(_buffers.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkDeque::~WorkDeque() { }
+
+    void WorkDeque::Push(Process *process)
+    {
+        index_type bottom = _bottom.load(std::memory_order_relaxed);
+        index_type top = _top.load(std::memory_order_acquire);
+        Buffer *buffer = _buffer.load(std::memory_order_relaxed);
+
+        if (bottom - top > buffer->mask) {
+            buffer = Grow(buffer, top, bottom);
+        }
+
+        buffer->Put(bottom, process);
+        std::atomic_thread_fence(std::memory_order_release);
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    Process *WorkDeque::Take()
+    {
+        index_type bottom = _bottom.load(std::memory_order_relaxed) - 1;
+        Buffer *buffer = _buffer.load(std::memory_order_relaxed);
+        _bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        index_type top = _top.load(std::memory_order_relaxed);
+
+        Process *process = NULL;
+        if (top <= bottom) {
+            process = buffer->Get(bottom);
+            if (top == bottom) {
+                // The last process, a thief may be taking it right now
+                if (!_top.compare_exchange_strong(top, top + 1,
+                                                  std::memory_order_seq_cst,
+                                                  std::memory_order_relaxed)) {
+                    process = NULL;
+                }
+                _bottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+        } else {
+            _bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        return process;
+    }
+
+    Process *WorkDeque::Steal()
+    {
+        index_type top = _top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        index_type bottom = _bottom.load(std::memory_order_acquire);
+
+        if (top >= bottom) {
+            return NULL;
+        }
+
+        Buffer *buffer = _buffer.load(std::memory_order_acquire);
+        Process *process = buffer->Get(top);
+        if (!_top.compare_exchange_strong(top, top + 1,
+                                          std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return NULL;
+        }
+
+        return process;
+    }
+
+    WorkDeque::Buffer *WorkDeque::Grow(Buffer *buffer, index_type top,
+                                       index_type bottom)
+    {
+        _buffers.push_back(std::unique_ptr<Buffer>(new Buffer((buffer->mask + 1) * 2)));
+        Buffer *grown = _buffers.back().get();
+        for (index_type index = top; index < bottom; ++index) {
+            grown->Put(index, buffer->Get(index));
+        }
+        _buffer.store(grown, std::memory_order_release);
+
+        return grown;
+    }
+}
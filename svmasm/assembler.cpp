@@ -0,0 +1,475 @@
+#include "assembler.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <iostream>
+
+#include "vmexe.h"
+
+namespace svmasm
+{
+    namespace
+    {
+        const char *MOV_OPCODE_TOKEN = "mov";
+        const int MOVA_OPCODE = 0x10;
+
+        const char *JMP_OPCODE_TOKEN = "jmp";
+        const int JMP_OPCODE = 0x20;
+
+        const char *INT_OPCODE_TOKEN = "int";
+        const int INT_OPCODE = 0x30;
+
+        const char *LD_OPCODE_TOKEN = "ld";
+        const int LDA_OPCODE = 0x40;
+
+        const char *ST_OPCODE_TOKEN = "st";
+        const int STA_OPCODE = 0x50;
+
+        const char *CODE_DIRECTIVE_TOKEN = ".code";
+        const char *DATA_DIRECTIVE_TOKEN = ".data";
+        const char *WORD_DIRECTIVE_TOKEN = ".word";
+        const char *BSS_DIRECTIVE_TOKEN = ".bss";
+        const char *ENTRY_DIRECTIVE_TOKEN = ".entry";
+
+        // Text translated between the releases of the source
+        const std::size_t RELEASE_BLOCK_SIZE = 0x1000000; // 16 MB
+
+        inline bool IsSpace(char character)
+        {
+            return character == ' ' || character == '\t' || character == '\r' ||
+                   character == '\v' || character == '\f';
+        }
+    }
+
+    CellWriter::CellWriter(std::FILE *file)
+        : _file(file),
+          _buffer(new int[BUFFER_SIZE]),
+          _used(0),
+          _count(0),
+          _has_failed(false) { }
+
+    void CellWriter::WriteZeroes(size_type count)
+    {
+        while (count-- > 0) {
+            Write(0);
+        }
+    }
+
+    bool CellWriter::Flush()
+    {
+        Drain();
+
+        return !_has_failed;
+    }
+
+    void CellWriter::Drain()
+    {
+        if (_used > 0 && !_has_failed &&
+                std::fwrite(_buffer.get(), sizeof(int), _used, _file) != _used) {
+            _has_failed = true;
+        }
+        _used = 0;
+    }
+
+    Assembler::Assembler(std::FILE *output, bool is_raw)
+        : _output(output),
+          _is_raw(is_raw),
+          _code(output),
+          _code_offset(0),
+          _data_file(NULL),
+          _data(),
+          _data_address(0),
+          _bss_size(0),
+          _entry_point(0),
+          _is_in_data(false),
+          _line_count(0)
+    {
+        // Room for the header, it is written when the sizes are known
+        if (!_is_raw) {
+            _code.WriteZeroes(svm::ExecutableHeader::DEFAULT_ALIGNMENT);
+            _code_offset = _code.Count();
+        }
+    }
+
+    Assembler::~Assembler()
+    {
+        if (_data_file != NULL) {
+            std::fclose(_data_file);
+        }
+    }
+
+    Assembler::size_type Assembler::CodeSize() const
+    {
+        return _code.Count() - _code_offset;
+    }
+
+    bool Assembler::Assemble(SourceFile &source)
+    {
+        const char *position = source.Begin();
+        const char *end = source.End();
+        while (position != end) {
+            // Blocks end after a line feed
+            const char *block_end = end;
+            if (static_cast<std::size_t>(end - position) > RELEASE_BLOCK_SIZE) {
+                const char *line_feed = static_cast<const char *>(
+                    std::memchr(position + RELEASE_BLOCK_SIZE, '\n',
+                                end - position - RELEASE_BLOCK_SIZE));
+                if (line_feed != NULL) {
+                    block_end = line_feed + 1;
+                }
+            }
+
+            if (!Translate(position, block_end)) {
+                return false;
+            }
+            source.Release(block_end);
+            position = block_end;
+        }
+
+        return Finish();
+    }
+
+    bool Assembler::Translate(const char *begin, const char *end)
+    {
+        const char *position = begin;
+        while (position != end) {
+            ++_line_count;
+
+            if (!TranslateLine(position, end)) {
+                return false;
+            }
+
+            // The rest of the line, usually just its line feed
+            if (position != end && *position != '\n') {
+                position = static_cast<const char *>(
+                    std::memchr(position, '\n', end - position));
+                if (position == NULL) {
+                    position = end;
+                }
+            }
+            if (position != end) {
+                ++position;
+            }
+        }
+
+        return true;
+    }
+
+    bool Assembler::TranslateLine(const char *&position, const char *end)
+    {
+        Token token;
+        if (!NextToken(position, end, token)) {
+            return true;
+        }
+
+        if (*token.begin == '.') {
+            if (IsKeyword(token, CODE_DIRECTIVE_TOKEN)) {
+                _is_in_data = false;
+            } else if (IsKeyword(token, DATA_DIRECTIVE_TOKEN)) {
+                int address;
+                if (NextToken(position, end, token)) {
+                    if (!ParseNumber(token, address) || address < 0 ||
+                            (DataSize() > 0 && static_cast<size_type>(address) != _data_address)) {
+                        return Error("Invalid data address.");
+                    }
+                    _data_address = address;
+                }
+                _is_in_data = true;
+            } else if (IsKeyword(token, WORD_DIRECTIVE_TOKEN)) {
+                CellWriter *section = _is_in_data ? DataWriter() : &_code;
+                if (section == NULL) {
+                    return Error("Failed to create a temporary file.");
+                }
+
+                int value;
+                while (NextToken(position, end, token)) {
+                    if (!ParseNumber(token, value)) {
+                        return Error("Invalid word value.");
+                    }
+                    section->Write(value);
+                }
+            } else if (IsKeyword(token, BSS_DIRECTIVE_TOKEN)) {
+                int size;
+                if (!NextToken(position, end, token) || !ParseNumber(token, size) || size < 0 ||
+                        static_cast<size_type>(size) > INT_MAX - _bss_size) {
+                    return Error("Invalid bss size.");
+                }
+                _bss_size += size;
+            } else if (IsKeyword(token, ENTRY_DIRECTIVE_TOKEN)) {
+                _entry_point = CodeSize();
+            }
+
+            return true;
+        }
+
+        if (_is_in_data) {
+            return Error("Instructions are not allowed in the data section.");
+        }
+
+        // The first letter tells the instructions apart, so a line costs
+        //  one keyword comparison
+        int instruction = 0;
+        bool has_register = true;
+        const char *operand_error = NULL;
+        switch (*token.begin)
+        {
+            case 'm': case 'M':
+                if (IsKeyword(token, MOV_OPCODE_TOKEN)) {
+                    instruction = MOVA_OPCODE;
+                    operand_error = "Invalid immediate value.";
+                }
+                break;
+            case 'l': case 'L':
+                if (IsKeyword(token, LD_OPCODE_TOKEN)) {
+                    instruction = LDA_OPCODE;
+                    operand_error = "Invalid data address.";
+                }
+                break;
+            case 's': case 'S':
+                if (IsKeyword(token, ST_OPCODE_TOKEN)) {
+                    instruction = STA_OPCODE;
+                    operand_error = "Invalid data address.";
+                }
+                break;
+            case 'j': case 'J':
+                if (IsKeyword(token, JMP_OPCODE_TOKEN)) {
+                    instruction = JMP_OPCODE;
+                    has_register = false;
+                    operand_error = "Invalid relative address.";
+                }
+                break;
+            case 'i': case 'I':
+                if (IsKeyword(token, INT_OPCODE_TOKEN)) {
+                    instruction = INT_OPCODE;
+                    has_register = false;
+                    operand_error = "Invalid interrupt number.";
+                }
+                break;
+        }
+        if (instruction == 0) {
+            return true;
+        }
+
+        if (has_register) {
+            if (!NextToken(position, end, token)) {
+                return Error("Invalid assembly statement.");
+            }
+
+            int offset = ParseRegister(token);
+            if (offset < 0) {
+                return Error("Invalid register specifier.");
+            }
+            instruction += offset;
+        }
+
+        // Data addresses (`ld`, `st`) can not be negative
+        int value;
+        if (!NextToken(position, end, token) || !ParseNumber(token, value) ||
+                (value < 0 && instruction >= LDA_OPCODE)) {
+            return Error(operand_error);
+        }
+
+        _code.Write(instruction);
+        _code.Write(value);
+
+        return true;
+    }
+
+    bool Assembler::Finish()
+    {
+        if (_is_raw) {
+            if (DataSize() > 0 || _bss_size > 0 || _entry_point != 0) {
+                std::cerr << "Raw executables have no data, bss or entry point."
+                          << std::endl;
+
+                return false;
+            }
+        } else {
+            // Sections start at multiples of the alignment
+            const size_type alignment = svm::ExecutableHeader::DEFAULT_ALIGNMENT;
+
+            size_type code_size = CodeSize();
+            if (_entry_point >= code_size) {
+                std::cerr << "No instruction at the entry point."
+                          << std::endl;
+
+                return false;
+            }
+
+            _code.WriteZeroes((alignment - _code.Count() % alignment) % alignment);
+            size_type data_offset = _code.Count();
+            size_type data_size = DataSize();
+            if (data_offset + data_size > INT_MAX || _data_address + data_size > INT_MAX) {
+                std::cerr << "The program is too large."
+                          << std::endl;
+
+                return false;
+            }
+
+            if (_data) {
+                if (!_data->Flush() || std::fseek(_data_file, 0, SEEK_SET) != 0) {
+                    std::cerr << "Failed to write a temporary file."
+                              << std::endl;
+
+                    return false;
+                }
+
+                std::unique_ptr<int[]> block(new int[CellWriter::BUFFER_SIZE]);
+                for (size_type count;
+                        (count = std::fread(block.get(), sizeof(int), CellWriter::BUFFER_SIZE, _data_file)) > 0;) {
+                    for (size_type i = 0; i < count; ++i) {
+                        _code.Write(block[i]);
+                    }
+                }
+                if (std::ferror(_data_file)) {
+                    std::cerr << "Failed to read a temporary file."
+                              << std::endl;
+
+                    return false;
+                }
+            }
+
+            svm::ExecutableHeader header = svm::ExecutableHeader();
+            header.magic = svm::ExecutableHeader::MAGIC;
+            header.version = svm::ExecutableHeader::VERSION;
+            header.header_size = sizeof(header) / sizeof(int);
+            header.alignment = static_cast<int>(alignment);
+            header.flags = 0;
+            header.entry_point = static_cast<int>(_entry_point);
+            header.code_offset = static_cast<int>(_code_offset);
+            header.code_size = static_cast<int>(code_size);
+            header.data_offset = static_cast<int>(data_offset);
+            header.data_size = static_cast<int>(data_size);
+            header.data_address = static_cast<int>(_data_address);
+            header.bss_size = static_cast<int>(_bss_size);
+            header.decoded_offset = 0;
+            header.decoded_size = 0;
+
+            if (!_code.Flush() || std::fseek(_output, 0, SEEK_SET) != 0 ||
+                    std::fwrite(&header, sizeof(header), 1, _output) != 1) {
+                std::cerr << "Failed to write the output file."
+                          << std::endl;
+
+                return false;
+            }
+        }
+
+        if (!_code.Flush() || std::fflush(_output) != 0) {
+            std::cerr << "Failed to write the output file."
+                      << std::endl;
+
+            return false;
+        }
+
+        return true;
+    }
+
+    bool Assembler::NextToken(const char *&position, const char *end, Token &token)
+    {
+        while (position != end && IsSpace(*position)) {
+            ++position;
+        }
+        if (position == end || *position == '\n') {
+            return false;
+        }
+
+        token.begin = position;
+        while (position != end && !IsSpace(*position) && *position != '\n') {
+            ++position;
+        }
+        token.end = position;
+
+        return true;
+    }
+
+    bool Assembler::IsKeyword(const Token &token, const char *keyword)
+    {
+        const char *character = token.begin;
+        for (; character != token.end && *keyword != '\0'; ++character, ++keyword) {
+            char lower = *character >= 'A' && *character <= 'Z' ?
+                             static_cast<char>(*character - 'A' + 'a') : *character;
+            if (lower != *keyword) {
+                return false;
+            }
+        }
+
+        return character == token.end && *keyword == '\0';
+    }
+
+    int Assembler::ParseRegister(const Token &token)
+    {
+        if (token.end - token.begin != 1) {
+            return -1;
+        }
+
+        switch (*token.begin)
+        {
+            case 'a': case 'A': return 0;
+            case 'b': case 'B': return 1;
+            case 'c': case 'C': return 2;
+            default: return -1;
+        }
+    }
+
+    bool Assembler::ParseNumber(const Token &token, int &value)
+    {
+        const char *character = token.begin;
+        bool is_negative = false;
+        if (*character == '-' || *character == '+') {
+            is_negative = *character == '-';
+            ++character;
+        }
+        if (character == token.end) {
+            return false;
+        }
+
+        // 18 digits can not overflow the accumulator, the range is checked
+        //  once at the end
+        while (token.end - character > 1 && *character == '0') {
+            ++character;
+        }
+        if (token.end - character > 18) {
+            return false;
+        }
+
+        long long result = 0;
+        for (; character != token.end; ++character) {
+            unsigned int digit = static_cast<unsigned int>(*character - '0');
+            if (digit > 9) {
+                return false;
+            }
+            result = result * 10 + digit;
+        }
+        if (is_negative) {
+            result = -result;
+        }
+        if (result < INT_MIN || result > INT_MAX) {
+            return false;
+        }
+        value = static_cast<int>(result);
+
+        return true;
+    }
+
+    CellWriter *Assembler::DataWriter()
+    {
+        if (!_data) {
+            _data_file = std::tmpfile();
+            if (_data_file == NULL) {
+                return NULL;
+            }
+            _data.reset(new CellWriter(_data_file));
+        }
+
+        return _data.get();
+    }
+
+    bool Assembler::Error(const char *message) const
+    {
+        std::cerr << "Line " << _line_count << ": " << message
+                  << std::endl;
+
+        return false;
+    }
+}
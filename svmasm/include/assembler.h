@@ -0,0 +1,147 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+
+#include "source_file.h"
+
+namespace svmasm
+{
+    // Buffered Output
+    //
+    // Collects cells in a fixed buffer and writes them to the file a block
+    //  at a time. A failed write is remembered and reported by `Flush`.
+    class CellWriter
+    {
+        public:
+            typedef std::size_t size_type;
+
+            static const size_type BUFFER_SIZE = 0x4000; // In cells
+
+            explicit CellWriter(std::FILE *file);
+
+            void Write(int cell)
+            {
+                if (_used == BUFFER_SIZE) {
+                    Drain();
+                }
+                _buffer[_used++] = cell;
+                ++_count;
+            }
+
+            void WriteZeroes(size_type count);
+
+            // Writes the buffer out, false if any write failed
+            bool Flush();
+
+            size_type Count() const // Cells written since the creation
+            {
+                return _count;
+            }
+
+        private:
+            std::FILE *_file;
+            std::unique_ptr<int[]> _buffer;
+            size_type _used;
+            size_type _count;
+            bool _has_failed;
+
+            void Drain();
+    };
+
+    // Assembler
+    //
+    // Translates `.vmasm` text into a `.vmexe` container (see
+    //  `svm::ExecutableHeader`) or, in the raw mode, into the bare
+    //  instructions. The text is tokenized in place and the instructions
+    //  are streamed to the output behind a placeholder header, which is
+    //  written last. The data section goes to a temporary file until the
+    //  code is complete, so the memory use does not depend on the size of
+    //  the program.
+    //
+    //     mov|ld|st <a|b|c> <value>  jmp <offset>  int <number>
+    //     .data [<address>]  .word <value>...  .bss <cells>  .code  .entry
+    //
+    // Keywords are case insensitive, lines with unknown statements are
+    //  skipped like in older versions. Errors are written to the standard
+    //  error with the line number.
+    class Assembler
+    {
+        public:
+            typedef std::size_t size_type;
+
+            Assembler(std::FILE *output, bool is_raw);
+            virtual ~Assembler();
+
+            // Translates the whole file and finishes the output, releasing
+            //  the text of the source as it goes
+            bool Assemble(SourceFile &source);
+
+            // Translates complete lines, the last one may lack its line feed
+            bool Translate(const char *begin, const char *end);
+
+            // Writes the data section and the header
+            bool Finish();
+
+            size_type LineCount() const
+            {
+                return _line_count;
+            }
+
+            size_type CodeSize() const; // In cells
+
+            size_type DataSize() const // In cells
+            {
+                return _data ? _data->Count() : 0;
+            }
+
+        private:
+            struct Token
+            {
+                const char *begin;
+                const char *end;
+            };
+
+            std::FILE *_output;
+            bool _is_raw;
+
+            CellWriter _code;
+            size_type _code_offset;
+
+            std::FILE *_data_file; // Temporary, created by the first data word
+            std::unique_ptr<CellWriter> _data;
+            size_type _data_address;
+            size_type _bss_size;
+            size_type _entry_point;
+            bool _is_in_data;
+
+            size_type _line_count;
+
+            Assembler(const Assembler &);
+            Assembler &operator=(const Assembler &);
+
+            // Leaves the position after the last token that was used
+            bool TranslateLine(const char *&position, const char *end);
+
+            // False at the end of the line, the line feed is not consumed
+            static bool NextToken(const char *&position, const char *end, Token &token);
+
+            // Case insensitive, the keyword is in lower case
+            static bool IsKeyword(const Token &token, const char *keyword);
+
+            // Returns the offset of the register from the `a` variant of an
+            //  opcode or -1 for an invalid register specifier
+            static int ParseRegister(const Token &token);
+
+            // A decimal `int`, false if the token is not one or overflows
+            static bool ParseNumber(const Token &token, int &value);
+
+            CellWriter *DataWriter(); // NULL if the file can not be created
+
+            bool Error(const char *message) const;
+    };
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef SOURCE_FILE_H
+#define SOURCE_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace svmasm
+{
+    // Assembly Source
+    //
+    // A `.vmasm` file mapped read-only into the host memory, so the
+    //  tokenizer works on the text in place. Text that was translated can
+    //  be released, its pages are dropped from the mapping and the memory
+    //  use stays flat however large the file is. Hosts without `mmap` and
+    //  files that can not be mapped (e.g., pipes) are read into a buffer.
+    class SourceFile
+    {
+        public:
+            SourceFile();
+            virtual ~SourceFile();
+
+            // False if the file can not be opened or read
+            bool Open(const std::string &path);
+
+            const char *Begin() const
+            {
+                return _begin;
+            }
+
+            const char *End() const
+            {
+                return _begin + _size;
+            }
+
+            // The text before the position is not needed any more
+            void Release(const char *position);
+
+        private:
+            const char *_begin;
+            std::size_t _size;
+
+            void *_mapping; // NULL if the text was read into `_buffer`
+            std::size_t _released; // Bytes at the start that were dropped
+            std::vector<char> _buffer;
+
+            SourceFile(const SourceFile &);
+            SourceFile &operator=(const SourceFile &);
+
+            void Close();
+    };
+}
+
+#endif
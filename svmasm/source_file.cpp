@@ -0,0 +1,107 @@
+#include "source_file.h"
+
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define SVMASM_SOURCE_MMAP
+#endif
+
+namespace svmasm
+{
+    SourceFile::SourceFile()
+        : _begin(NULL),
+          _size(0),
+          _mapping(NULL),
+          _released(0),
+          _buffer() { }
+
+    SourceFile::~SourceFile()
+    {
+        Close();
+    }
+
+    bool SourceFile::Open(const std::string &path)
+    {
+        Close();
+
+#if defined(SVMASM_SOURCE_MMAP)
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0) {
+            return false;
+        }
+
+        struct stat status;
+        if (fstat(file, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+            void *mapping = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+            if (mapping != MAP_FAILED) {
+                // The text is read once from the start to the end
+                madvise(mapping, status.st_size, MADV_SEQUENTIAL);
+
+                _mapping = mapping;
+                _begin = static_cast<const char *>(mapping);
+                _size = status.st_size;
+            }
+        }
+        close(file);
+
+        if (_mapping != NULL) {
+            return true;
+        }
+#endif
+
+        std::ifstream input_stream(path, std::ios::in | std::ios::binary);
+        if (!input_stream) {
+            return false;
+        }
+
+        char block[0x10000];
+        while (input_stream.read(block, sizeof(block)) || input_stream.gcount() > 0) {
+            _buffer.insert(_buffer.end(), block, block + input_stream.gcount());
+        }
+        if (input_stream.bad()) {
+            return false;
+        }
+
+        _begin = _buffer.empty() ? NULL : &_buffer[0];
+        _size = _buffer.size();
+
+        return true;
+    }
+
+    void SourceFile::Release(const char *position)
+    {
+#if defined(SVMASM_SOURCE_MMAP)
+        if (_mapping == NULL) {
+            return;
+        }
+
+        // Whole pages only, the rest is released with the next call
+        std::size_t page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        std::size_t released = static_cast<std::size_t>(position - _begin) / page_size * page_size;
+        if (released > _released) {
+            madvise(static_cast<char *>(_mapping) + _released, released - _released, MADV_DONTNEED);
+            _released = released;
+        }
+#else
+        (void) position;
+#endif
+    }
+
+    void SourceFile::Close()
+    {
+#if defined(SVMASM_SOURCE_MMAP)
+        if (_mapping != NULL) {
+            munmap(_mapping, _size);
+        }
+#endif
+        _mapping = NULL;
+        _begin = NULL;
+        _size = 0;
+        _released = 0;
+        std::vector<char>().swap(_buffer);
+    }
+}
@@ -1,159 +1,66 @@
+#include <cstdio>
 #include <iostream>
-#include <fstream>
 #include <string>
-#include <sstream>
-#include <vector>
-#include <algorithm>
-#include <cctype>
 
-static const char *MOV_OPCODE_TOKEN = "mov";
-static const char *REGISTER_A_TOKEN = "a";
-static const char *REGISTER_B_TOKEN = "b";
-static const char *REGISTER_C_TOKEN = "c";
-static const int MOVA_OPCODE = 0x10;
-static const int MOVB_OPCODE = 0x11;
-static const int MOVC_OPCODE = 0x12;
+#include "assembler.h"
+#include "source_file.h"
 
-static const char *JMP_OPCODE_TOKEN = "jmp";
-static const int JMP_OPCODE = 0x20;
-
-static const char *INT_OPCODE_TOKEN = "int";
-static const int INT_OPCODE = 0x30;
+static const char *RAW_OPTION = "/raw";
 
 // Converts assembly code to virtual CPU instructions
 //     `mov a 42` -> `0x10 0x2A`
+//
+// The instructions go to the code section of a `.vmexe` container (see
+//  `svm::ExecutableHeader`), `.word` values after `.data [address]` go to
+//  its data section. `.code` switches back to the instructions, `.bss
+//  <cells>` reserves zeroes after the data and `.entry` marks the first
+//  instruction to run. `/raw` writes the bare instructions of older
+//  versions instead. See `svmasm::Assembler`.
 
 int main(int argc, char *argv[])
 {
-    if (argc >= 3) {
-        std::string input_file;
-
-        std::string input_file_name(argv[1]);
-        std::string output_file_name(argv[2]);
+    bool is_raw = argc >= 2 && std::string(argv[1]) == RAW_OPTION;
+    if (is_raw) {
+        --argc;
+        ++argv;
+    }
 
-        std::ifstream input_stream(argv[1]);
-        if (!input_stream) {
+    if (argc >= 3) {
+        svmasm::SourceFile source;
+        if (!source.Open(argv[1])) {
             std::cerr << "Failed to open the input file."
                       << std::endl;
 
             return -1;
         }
 
-        std::ofstream output_stream(
-            argv[2],
-            std::ios::out | std::ios::binary
-        );
-        if (!output_stream) {
+        std::FILE *output_file = std::fopen(argv[2], "wb");
+        if (output_file == NULL) {
             std::cerr << "Failed to open the output file."
                       << std::endl;
 
             return -1;
         }
 
-        std::vector<int> ops;
-
-        for (std::string line; std::getline(input_stream, line);) {
-            std::stringstream tokens(line); std::string token;
-            if (tokens >> token) {
-                std::transform(
-                    token.begin(),
-                    token.end(),
-                    token.begin(),
-                    tolower
-                );
-
-                if (token == MOV_OPCODE_TOKEN) {
-                    int instruction, data;
-                    if (tokens >> token) {
-                        std::transform(
-                            token.begin(),
-                            token.end(),
-                            token.begin(),
-                            tolower
-                        );
-
-                        if (token == REGISTER_A_TOKEN) {
-                            instruction = MOVA_OPCODE;
-                        } else if (token == REGISTER_B_TOKEN) {
-                            instruction = MOVB_OPCODE;
-                        } else if (token == REGISTER_C_TOKEN) {
-                            instruction = MOVC_OPCODE;
-                        } else {
-                            std::cerr << "Invalid register specifier."
-                                      << std::endl;
-
-                            return -1;
-                        }
-
-                        if (!(tokens >> data)) {
-                            std::cerr << "Invalid immediate value."
-                                      << std::endl;
-
-                            return -1;
-                        }
-
-                        ops.push_back(instruction);
-                        ops.push_back(data);
-                    } else {
-                        std::cerr << "Invalid assembly statement."
-                                  << std::endl;
-
-                        return -1;
-                    }
-                } else if (token == JMP_OPCODE_TOKEN) {
-                    int instruction =
-                        JMP_OPCODE;
-
-                    int data;
-                    if (!(tokens >> data)) {
-                        std::cerr << "Invalid relative address."
-                                  << std::endl;
-                    }
-
-                    ops.push_back(instruction);
-                    ops.push_back(data);
-                } else if (token == INT_OPCODE_TOKEN) {
-                    int instruction =
-                        INT_OPCODE;
-
-                    int data;
-                    if (!(tokens >> data)) {
-                        std::cerr << "Invalid interrupt number."
-                                  << std::endl;
-
-                        return -1;
-                    }
-
-                    ops.push_back(instruction);
-                    ops.push_back(data);
-                }
-            }
-
-            input_file.append(line);
+        bool is_assembled;
+        {
+            svmasm::Assembler assembler(output_file, is_raw);
+            is_assembled = assembler.Assemble(source);
         }
 
-        if (input_stream.bad()) {
-            std::cerr << "Failed to read the input file."
+        if (std::fclose(output_file) != 0 && is_assembled) {
+            std::cerr << "Failed to write the output file."
                       << std::endl;
 
             return -1;
         }
-
-        output_stream.write(
-            reinterpret_cast<const char *>(&ops[0]),
-            ops.size() * sizeof(int)
-        );
-
-        if (output_stream.bad()) {
-            std::cerr << "Failed to write the output file."
-                      << std::endl;
-
+        if (!is_assembled) {
             return -1;
         }
     } else {
         std::cerr << "The syntax of the command is incorrect."
                   << std::endl
-                  << " vmasm <input file> <output file>"
+                  << " vmasm [/raw] <input file> <output file>"
                   << std::endl << std::endl;
 
         return -1;
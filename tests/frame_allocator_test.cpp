@@ -0,0 +1,214 @@
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "frame_allocator.h"
+
+// Checks the lock-free frame allocator and the per-CPU frame caches
+//
+// The single-threaded part covers the frame 0, exhaustion and runs across
+//  a word of the bitmap. Then several threads acquire and release single
+//  frames through their caches and runs of frames directly on a small
+//  allocator, so runs are often broken by a concurrent claim. A frame
+//  must never be handed out twice and every frame must be free again at
+//  the end.
+
+namespace
+{
+    typedef svm::FrameAllocator::frame_type frame_type;
+    typedef svm::FrameAllocator::size_type size_type;
+
+    const size_type FRAME_COUNT = 200; // The last word is partial
+    const size_type FRAME_SIZE = 16;
+    const size_type WORD_BITS = 64;
+
+    const unsigned int THREAD_COUNT = 4;
+    const unsigned int ITERATION_COUNT = 200000;
+    const size_type MAX_HELD_FRAMES = 24; // Per thread
+    const size_type MAX_RUN = 8;
+
+    bool Fail(const char *message)
+    {
+        std::cerr << "FrameAllocator: " << message << std::endl;
+
+        return false;
+    }
+
+    bool IsValid(frame_type frame)
+    {
+        return frame != svm::FrameAllocator::INVALID_FRAME &&
+               frame % FRAME_SIZE == 0 &&
+               frame / FRAME_SIZE < FRAME_COUNT;
+    }
+
+    bool CheckAll(svm::FrameAllocator &allocator)
+    {
+        if (allocator.FreeCount() != FRAME_COUNT - 1) {
+            return Fail("the free count is wrong");
+        }
+
+        std::vector<bool> is_taken(FRAME_COUNT, false);
+        for (size_type i = 0; i < FRAME_COUNT - 1; ++i) {
+            frame_type frame = allocator.Acquire();
+            if (!IsValid(frame)) {
+                return Fail("an invalid frame or the frame 0 was handed out");
+            }
+            if (is_taken[frame / FRAME_SIZE]) {
+                return Fail("a frame was handed out twice");
+            }
+            is_taken[frame / FRAME_SIZE] = true;
+        }
+        if (allocator.Acquire() != svm::FrameAllocator::INVALID_FRAME ||
+            allocator.FreeCount() != 0) {
+            return Fail("a frame was handed out after the last one");
+        }
+
+        for (size_type i = 1; i < FRAME_COUNT; ++i) {
+            allocator.Release(i * FRAME_SIZE);
+        }
+
+        if (allocator.FreeCount() != FRAME_COUNT - 1) {
+            return Fail("the free count is wrong after the release");
+        }
+
+        return true;
+    }
+
+    bool CheckContiguous(svm::FrameAllocator &allocator)
+    {
+        for (size_type i = 1; i < FRAME_COUNT; ++i) {
+            allocator.Acquire();
+        }
+
+        // A run across the first word boundary
+        size_type first = WORD_BITS - 4;
+        for (size_type i = first; i < first + 10; ++i) {
+            allocator.Release(i * FRAME_SIZE);
+        }
+        if (allocator.AcquireContiguous(11) != svm::FrameAllocator::INVALID_FRAME) {
+            return Fail("a run longer than the free frames was handed out");
+        }
+        if (allocator.AcquireContiguous(10) != first * FRAME_SIZE) {
+            return Fail("a run across a word boundary was not found");
+        }
+        if (allocator.FreeCount() != 0) {
+            return Fail("the free count is wrong after a run");
+        }
+
+        // The same run with a taken frame in the middle
+        for (size_type i = first; i < first + 10; ++i) {
+            if (i != first + 4) {
+                allocator.Release(i * FRAME_SIZE);
+            }
+        }
+        if (allocator.AcquireContiguous(5) != (first + 5) * FRAME_SIZE) {
+            return Fail("a run after a taken frame was not found");
+        }
+        if (allocator.AcquireContiguous(4) != first * FRAME_SIZE) {
+            return Fail("a run before a taken frame was not found");
+        }
+
+        // Runs never start at the frame 0
+        allocator.Reset();
+        if (allocator.AcquireContiguous(FRAME_COUNT) != svm::FrameAllocator::INVALID_FRAME) {
+            return Fail("a run with the frame 0 was handed out");
+        }
+        if (allocator.AcquireContiguous(FRAME_COUNT - 1) != FRAME_SIZE) {
+            return Fail("the run of every free frame was not found");
+        }
+        allocator.Reset();
+
+        return true;
+    }
+
+    bool CheckConcurrent(svm::FrameAllocator &allocator)
+    {
+        std::unique_ptr<std::atomic<bool>[]> is_owned(new std::atomic<bool>[FRAME_COUNT]);
+        for (size_type i = 0; i < FRAME_COUNT; ++i) {
+            is_owned[i].store(false, std::memory_order_relaxed);
+        }
+        std::atomic<bool> has_failed(false);
+
+        // Marks the frames of a thread, a frame that is owned already was
+        //  handed out twice
+        auto take = [&](frame_type frame, size_type count) {
+            for (size_type i = 0; i < count; ++i) {
+                frame_type next = frame + i * FRAME_SIZE;
+                if (!IsValid(next) ||
+                        is_owned[next / FRAME_SIZE].exchange(true)) {
+                    has_failed.store(true);
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned int t = 0; t < THREAD_COUNT; ++t) {
+            threads.push_back(std::thread([&, t]() {
+                std::minstd_rand random(t + 1);
+                svm::FrameCache cache(allocator);
+                std::vector<frame_type> held;
+
+                for (unsigned int i = 0; i < ITERATION_COUNT; ++i) {
+                    unsigned int choice = random() % 4;
+                    if (held.size() >= MAX_HELD_FRAMES || (choice == 0 && !held.empty())) {
+                        while (!held.empty()) {
+                            frame_type frame = held.back();
+                            held.pop_back();
+                            is_owned[frame / FRAME_SIZE].store(false);
+                            if (random() % 2 == 0) {
+                                cache.Release(frame);
+                            } else {
+                                allocator.Release(frame);
+                            }
+                        }
+                    } else if (choice == 1) {
+                        size_type count = 2 + random() % (MAX_RUN - 1);
+                        frame_type frame = allocator.AcquireContiguous(count);
+                        if (frame != svm::FrameAllocator::INVALID_FRAME) {
+                            take(frame, count);
+                            for (size_type j = 0; j < count; ++j) {
+                                held.push_back(frame + j * FRAME_SIZE);
+                            }
+                        }
+                    } else {
+                        frame_type frame = choice == 2 ? cache.Acquire() : allocator.Acquire();
+                        if (frame != svm::FrameAllocator::INVALID_FRAME) {
+                            take(frame, 1);
+                            held.push_back(frame);
+                        }
+                    }
+                }
+
+                for (std::size_t j = 0; j < held.size(); ++j) {
+                    is_owned[held[j] / FRAME_SIZE].store(false);
+                    allocator.Release(held[j]);
+                }
+            }));
+        }
+        for (std::size_t t = 0; t < threads.size(); ++t) {
+            threads[t].join();
+        }
+
+        if (has_failed.load()) {
+            return Fail("a frame was handed out twice or was invalid");
+        }
+
+        // Every cache is drained, every frame is free again
+        return CheckAll(allocator);
+    }
+}
+
+int main()
+{
+    svm::FrameAllocator allocator(FRAME_COUNT, FRAME_SIZE);
+
+    if (!CheckAll(allocator) || !CheckContiguous(allocator) ||
+            !CheckConcurrent(allocator)) {
+        return -1;
+    }
+
+    return 0;
+}
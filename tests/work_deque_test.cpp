@@ -0,0 +1,168 @@
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "process.h"
+#include "work_deque.h"
+
+// Checks the work-stealing deque of the kernel
+//
+// The owner pushes processes in bursts longer than the initial capacity,
+//  so the buffer grows while the thieves are stealing, and takes some of
+//  them back between the bursts. Then it pushes and takes one process at a
+//  time to race the thieves for the last one. Every process has to come
+//  out of the deque exactly once.
+
+namespace
+{
+    const unsigned int THIEF_COUNT = 3;
+    const unsigned int ROUND_COUNT = 20;
+    const unsigned int PROCESS_COUNT = 20000;
+    const unsigned int BURST = svm::WorkDeque::INITIAL_CAPACITY * 8;
+
+    bool Fail(const char *message)
+    {
+        std::cerr << "WorkDeque: " << message << std::endl;
+
+        return false;
+    }
+
+    // Without thieves the owner takes in the LIFO order, a thief steals in
+    //  the FIFO order
+    bool CheckOrder(const std::vector<std::unique_ptr<svm::Process> > &processes)
+    {
+        svm::WorkDeque deque;
+
+        unsigned int count = svm::WorkDeque::INITIAL_CAPACITY * 4;
+        for (unsigned int i = 0; i < count; ++i) {
+            deque.Push(processes[i].get());
+        }
+        if (deque.Size() != static_cast<svm::WorkDeque::index_type>(count)) {
+            return Fail("the size is wrong after a growth");
+        }
+
+        for (unsigned int i = 0; i < count / 2; ++i) {
+            if (deque.Steal() != processes[i].get()) {
+                return Fail("a steal did not return the first pushed process");
+            }
+        }
+        for (unsigned int i = count; i > count / 2; --i) {
+            if (deque.Take() != processes[i - 1].get()) {
+                return Fail("a take did not return the last pushed process");
+            }
+        }
+
+        if (!deque.IsEmpty() || deque.Take() != NULL || deque.Steal() != NULL) {
+            return Fail("the deque is not empty");
+        }
+
+        return true;
+    }
+
+    bool CheckRound(const std::vector<std::unique_ptr<svm::Process> > &processes)
+    {
+        svm::WorkDeque deque;
+
+        std::unique_ptr<std::atomic<unsigned int>[]> seen(
+            new std::atomic<unsigned int>[PROCESS_COUNT]);
+        for (unsigned int i = 0; i < PROCESS_COUNT; ++i) {
+            seen[i].store(0, std::memory_order_relaxed);
+        }
+
+        std::atomic<unsigned int> out_count(0);
+        std::atomic<unsigned int> started_count(0);
+
+        auto record = [&](svm::Process *process) {
+            seen[process->id].fetch_add(1, std::memory_order_relaxed);
+            out_count.fetch_add(1, std::memory_order_relaxed);
+        };
+
+        std::vector<std::thread> thieves;
+        for (unsigned int i = 0; i < THIEF_COUNT; ++i) {
+            thieves.push_back(std::thread([&]() {
+                started_count.fetch_add(1);
+                while (out_count.load(std::memory_order_relaxed) < PROCESS_COUNT) {
+                    svm::Process *process = deque.Steal();
+                    if (process != NULL) {
+                        record(process);
+                    }
+                }
+            }));
+        }
+        while (started_count.load() < THIEF_COUNT) {
+            std::this_thread::yield();
+        }
+
+        // Bursts grow the buffer, the rest is pushed and taken one by one,
+        //  so the owner and the thieves race for the last process
+        unsigned int pushed = 0;
+        while (pushed < PROCESS_COUNT / 2) {
+            for (unsigned int i = 0; i < BURST && pushed < PROCESS_COUNT; ++i) {
+                deque.Push(processes[pushed++].get());
+            }
+            for (unsigned int i = 0; i < BURST / 2; ++i) {
+                svm::Process *process = deque.Take();
+                if (process == NULL) {
+                    break;
+                }
+                record(process);
+            }
+        }
+        while (pushed < PROCESS_COUNT) {
+            deque.Push(processes[pushed++].get());
+            svm::Process *process = deque.Take();
+            if (process != NULL) {
+                record(process);
+            }
+        }
+        while (out_count.load(std::memory_order_relaxed) < PROCESS_COUNT) {
+            svm::Process *process = deque.Take();
+            if (process != NULL) {
+                record(process);
+            }
+        }
+
+        for (std::size_t i = 0; i < thieves.size(); ++i) {
+            thieves[i].join();
+        }
+
+        if (out_count.load() != PROCESS_COUNT) {
+            return Fail("more processes came out than were pushed");
+        }
+        for (unsigned int i = 0; i < PROCESS_COUNT; ++i) {
+            if (seen[i].load() != 1) {
+                std::cerr << "WorkDeque: the process " << i << " came out "
+                          << seen[i].load() << " times" << std::endl;
+
+                return false;
+            }
+        }
+        if (!deque.IsEmpty()) {
+            return Fail("the deque is not empty");
+        }
+
+        return true;
+    }
+}
+
+int main()
+{
+    std::vector<std::unique_ptr<svm::Process> > processes;
+    for (unsigned int i = 0; i < PROCESS_COUNT; ++i) {
+        processes.push_back(std::unique_ptr<svm::Process>(
+            new svm::Process(i, 0, 0, NULL)));
+    }
+
+    if (!CheckOrder(processes)) {
+        return -1;
+    }
+    for (unsigned int round = 0; round < ROUND_COUNT; ++round) {
+        if (!CheckRound(processes)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}